@@ -0,0 +1,287 @@
+// Hot-loop benchmarks for the bridge, at 15, 150 and 1500 tags:
+//   read    ACSharedOut::readInto() on pages fed by the synthetic source
+//   encode  PreparedWrite::update()/select() plus binary encoding of the
+//           WriteRequest, as the client does before it hits the socket
+//   publish sample -> write -> response against an in-process open62541
+//           server holding the same ns=3 string nodes as the Galaxy
+//           (sync round trips, then pipelined writes for throughput)
+//
+//   Benchmark [--iterations N] [--seconds S] [--port P] [--no-server]
+//
+// The pages are created by the benchmark itself, so do not run it next to
+// the game.
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include "ACPageWriter.h"
+#include "ACSharedOut.h"
+#include "AllocCounter.h"
+#include "AsyncWriter.h"
+#include "PreparedWrite.h"
+#include "PublishPlan.h"
+#include "SyntheticTelemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using benchClock = std::chrono::steady_clock;
+
+// Raw latency samples; sorted once when reported
+class Samples {
+public:
+    void reserve(size_t n) { ns.reserve(n); }
+    void add(benchClock::duration d) { ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()); }
+    size_t size() const { return ns.size(); }
+
+    double percentileUs(double p) {
+        if (ns.empty()) return 0;
+        if (!sorted) { std::sort(ns.begin(), ns.end()); sorted = true; }
+        size_t k = static_cast<size_t>(p * (ns.size() - 1) + 0.5);
+        return ns[k] / 1000.0;
+    }
+
+private:
+    std::vector<int64_t> ns;
+    bool sorted{ false };
+};
+
+static void printHeader() {
+    std::printf("%-10s %6s %10s %10s %10s %12s  %s\n", "bench", "tags", "p50 us", "p99 us", "p999 us", "ops/s", "notes");
+}
+
+static void printRow(const char* bench, size_t tags, Samples& s, double seconds, const std::string& notes) {
+    std::printf("%-10s %6zu %10.2f %10.2f %10.2f %12.0f  %s\n", bench, tags, s.percentileUs(0.50), s.percentileUs(0.99),
+        s.percentileUs(0.999), seconds > 0 ? s.size() / seconds : 0.0, notes.c_str());
+}
+
+// Tag map of n scalar tags over every numeric page element, as a site with
+// a large chassis data set would configure it. Every 50th tag is a lap time.
+static bool buildPlan(PublishPlan& plan, size_t n) {
+    std::vector<std::string> sources;
+    std::vector<std::string> types;
+    for (const ACPageField& f : acPageFields) {
+        for (size_t e = 0; e < f.count; ++e) {
+            std::string src = std::string(f.page == ACPage::Physics ? "physics." : "graphics.") + f.name;
+            if (f.count > 1) src += "[" + std::to_string(e) + "]";
+            sources.push_back(src);
+            types.push_back(f.type == ACSourceType::Int32 ? "int32" : "float");
+        }
+    }
+
+    std::ostringstream map;
+    for (size_t k = 0; k < n; ++k) {
+        char nodeId[32];
+        std::snprintf(nodeId, sizeof(nodeId), "719:Bench.tag%04zu", k);
+        if (k % 50 == 49) map << nodeId << ",graphics.iCurrentTime,laptime\n";
+        else map << nodeId << "," << sources[k % sources.size()] << "," << types[k % types.size()] << "\n";
+    }
+    std::istringstream in(map.str());
+    return plan.parse(in, "bench");
+}
+
+static void benchRead(ACSharedOut& ac, ACPageWriter& pages, SyntheticTelemetry& synth, size_t tags, int iterations) {
+    Samples s;
+    s.reserve(iterations);
+    auto total = benchClock::duration::zero();
+    ACSharedOutData snap; // reused like the sampler's
+    for (int i = 0; i < iterations; ++i) {
+        synth.step();
+        pages.write(synth.physics(), synth.graphicsPage());
+        auto t0 = benchClock::now();
+        bool ok = ac.readInto(snap);
+        auto t1 = benchClock::now();
+        if (!ok) { std::cerr << "readInto failed\n"; return; }
+        s.add(t1 - t0);
+        total += t1 - t0;
+    }
+    printRow("read", tags, s, std::chrono::duration<double>(total).count(), "");
+}
+
+static void benchEncode(ACSharedOut& ac, ACPageWriter& pages, SyntheticTelemetry& synth, PreparedWrite& writer,
+                        size_t tags, int iterations) {
+    size_t bytes = UA_calcSizeBinary(&writer.request(), &UA_TYPES[UA_TYPES_WRITEREQUEST]);
+    UA_ByteString buf;
+    if (UA_ByteString_allocBuffer(&buf, bytes + 4096) != UA_STATUSCODE_GOOD) return;
+
+    Samples s;
+    s.reserve(iterations);
+    auto total = benchClock::duration::zero();
+    uint64_t allocs = 0;
+    ACSharedOutData snap;
+    for (int i = 0; i < iterations; ++i) {
+        synth.step();
+        pages.write(synth.physics(), synth.graphicsPage());
+        ac.readInto(snap);
+
+        auto t0 = benchClock::now();
+        uint64_t allocsBefore = heapAllocations();
+        writer.update(snap);
+        writer.select(nullptr);
+        allocs += heapAllocations() - allocsBefore;
+        UA_ByteString out = buf; // encode into the preallocated buffer
+        UA_StatusCode sc = UA_encodeBinary(&writer.request(), &UA_TYPES[UA_TYPES_WRITEREQUEST], &out);
+        auto t1 = benchClock::now();
+        if (sc != UA_STATUSCODE_GOOD) { std::cerr << "encode failed: " << UA_StatusCode_name(sc) << "\n"; break; }
+        if (out.data != buf.data) UA_ByteString_clear(&out); // this open62541 allocated its own
+        s.add(t1 - t0);
+        total += t1 - t0;
+    }
+    UA_ByteString_clear(&buf);
+
+    char notes[96];
+    std::snprintf(notes, sizeof(notes), "%zu B/request, %.2f allocs/update", bytes, iterations ? double(allocs) / iterations : 0.0);
+    printRow("encode", tags, s, std::chrono::duration<double>(total).count(), notes);
+}
+
+// Variables the bridge writes, with the types it writes them as
+static bool addNodes(UA_Server* server, const PublishPlan& plan) {
+    // The bridge writes ns=3; a minimal server has 0 and 1, so fill 2 first
+    if (UA_Server_addNamespace(server, "urn:bench:filler") != 2) return false;
+    UA_UInt16 ns = UA_Server_addNamespace(server, "urn:bench:galaxy");
+    if (ns != 3) { std::cerr << "Bench namespace landed at " << ns << ", not 3\n"; return false; }
+
+    for (size_t k = 0; k < plan.size(); ++k) {
+        const ACField& f = plan.fields()[k];
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        UA_Int32 i = 0;
+        UA_Float x = 0;
+        UA_String text = UA_STRING(const_cast<char*>(""));
+        switch (f.type) {
+        case ACValueType::Int32: UA_Variant_setScalar(&attr.value, &i, &UA_TYPES[UA_TYPES_INT32]); break;
+        case ACValueType::Float: UA_Variant_setScalar(&attr.value, &x, &UA_TYPES[UA_TYPES_FLOAT]); break;
+        case ACValueType::LapTime: UA_Variant_setScalar(&attr.value, &text, &UA_TYPES[UA_TYPES_STRING]); break;
+        }
+        attr.dataType = attr.value.type->typeId;
+        attr.valueRank = UA_VALUERANK_SCALAR;
+        attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE | UA_ACCESSLEVELMASK_TIMESTAMPWRITE;
+        attr.displayName = UA_LOCALIZEDTEXT(const_cast<char*>(""), const_cast<char*>(f.nodeId));
+
+        UA_StatusCode sc = UA_Server_addVariableNode(server, UA_NODEID_STRING(ns, const_cast<char*>(f.nodeId)),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+            UA_QUALIFIEDNAME(ns, const_cast<char*>(f.nodeId)), UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+            attr, nullptr, nullptr);
+        if (sc != UA_STATUSCODE_GOOD) {
+            std::cerr << "Cannot add node " << f.nodeId << ": " << UA_StatusCode_name(sc) << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+static void benchPublish(ACSharedOut& ac, ACPageWriter& pages, SyntheticTelemetry& synth, const PublishPlan& plan,
+                         int port, double seconds) {
+    UA_Server* server = UA_Server_new();
+    UA_ServerConfig_setMinimal(UA_Server_getConfig(server), static_cast<UA_UInt16>(port), nullptr);
+    if (!addNodes(server, plan)) { UA_Server_delete(server); return; }
+    volatile UA_Boolean serverRunning = true;
+    std::thread serverThread([&] { UA_Server_run(server, &serverRunning); });
+
+    UA_Client* client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+    std::string url = "opc.tcp://localhost:" + std::to_string(port);
+    UA_StatusCode sc = UA_STATUSCODE_BADSERVERNOTCONNECTED;
+    for (int attempt = 0; attempt < 50 && sc != UA_STATUSCODE_GOOD; ++attempt) {
+        sc = UA_Client_connect(client, url.c_str());
+        if (sc != UA_STATUSCODE_GOOD) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    PreparedWrite writer;
+    if (sc != UA_STATUSCODE_GOOD) std::cerr << "Cannot connect to the bench server: " << UA_StatusCode_name(sc) << "\n";
+    else if (writer.build(plan.fields(), plan.size())) {
+        // Sync: one round trip per sample, timed from the read
+        Samples s;
+        size_t failed = 0;
+        auto end = benchClock::now() + std::chrono::duration<double>(seconds);
+        auto start = benchClock::now();
+        ACSharedOutData snap;
+        while (benchClock::now() < end) {
+            synth.step();
+            pages.write(synth.physics(), synth.graphicsPage());
+            auto t0 = benchClock::now();
+            ac.readInto(snap);
+            writer.update(snap);
+            if (!writer.send(client)) ++failed;
+            s.add(benchClock::now() - t0);
+        }
+        double elapsed = std::chrono::duration<double>(benchClock::now() - start).count();
+        printRow("publish", plan.size(), s, elapsed, failed ? std::to_string(failed) + " failed" : "sync");
+
+        // Pipelined: keep a window of requests in flight, count acknowledgements
+        AsyncWriter async(4, writer.size(), plan.valueCount());
+        end = benchClock::now() + std::chrono::duration<double>(seconds);
+        start = benchClock::now();
+        while (benchClock::now() < end) {
+            if (async.full()) { UA_Client_run_iterate(client, 1); continue; }
+            synth.step();
+            pages.write(synth.physics(), synth.graphicsPage());
+            ac.readInto(snap);
+            writer.update(snap);
+            async.send(client, writer, snap);
+            UA_Client_run_iterate(client, 0);
+        }
+        async.drain(client, 2000);
+        elapsed = std::chrono::duration<double>(benchClock::now() - start).count();
+        std::printf("%-10s %6zu %10s %10s %10s %12.0f  window 4, %llu failed\n", "pipelined", plan.size(), "-", "-", "-",
+            async.stats().acked / elapsed, static_cast<unsigned long long>(async.stats().failedRequests));
+    }
+
+    writer.clear();
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    serverRunning = false;
+    serverThread.join();
+    UA_Server_delete(server);
+}
+
+int main(int argc, char** argv) {
+    int iterations = 20000;
+    double seconds = 3.0;
+    int port = 4841;
+    bool withServer = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) iterations = std::atoi(argv[++i]);
+        else if (arg == "--seconds" && i + 1 < argc) seconds = std::atof(argv[++i]);
+        else if (arg == "--port" && i + 1 < argc) port = std::atoi(argv[++i]);
+        else if (arg == "--no-server") withServer = false;
+        else {
+            std::cerr << "Usage: Benchmark [--iterations N] [--seconds S] [--port P] [--no-server]\n";
+            return 1;
+        }
+    }
+
+    ACPageWriter pages;
+    if (!pages.create()) { std::cerr << "Failed to create the shared memory pages.\n"; return 1; }
+    SyntheticTelemetry synth(SyntheticConfig{});
+    synth.step();
+    pages.write(synth.physics(), synth.graphicsPage());
+
+    ACSharedOut ac;
+    if (!ac.initialize()) { std::cerr << "Failed to open the shared memory pages.\n"; return 1; }
+
+    printHeader();
+    const size_t tagCounts[] = { 15, 150, 1500 };
+    for (size_t tags : tagCounts) {
+        PublishPlan plan;
+        if (!buildPlan(plan, tags) || !ac.setFields(plan.fields(), plan.size())) return 1;
+
+        benchRead(ac, pages, synth, tags, iterations);
+
+        PreparedWrite writer;
+        if (!writer.build(plan.fields(), plan.size())) { std::cerr << "Failed to prepare write request\n"; return 1; }
+        benchEncode(ac, pages, synth, writer, tags, iterations);
+        writer.clear();
+
+        if (withServer) benchPublish(ac, pages, synth, plan, port, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "ACSharedOut.h"
+#include "SharedMemory.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+
+// Producer side of the AC pages: creates acpmf_physics / acpmf_graphics (or
+// another mapping stem, see ACSharedOut::initialize()) and publishes whole
+// frames into them the way the game does (body first, packetId last), so
+// ACSharedOut reads them unmodified.
+class ACPageWriter {
+public:
+    ACPageWriter() : physicsPage(makeSharedMemoryPage()), graphicsPage(makeSharedMemoryPage()) {}
+    ~ACPageWriter() { close(); }
+
+    bool create(const std::string& mapping = "acpmf") {
+        if (!physicsPage->create(mapping + "_physics", sizeof(SPageFilePhysics))) return false;
+        if (!graphicsPage->create(mapping + "_graphics", sizeof(SPageFileGraphics))) { close(); return false; }
+        std::memset(physicsPage->data(), 0, sizeof(SPageFilePhysics));
+        std::memset(graphicsPage->data(), 0, sizeof(SPageFileGraphics));
+        return true;
+    }
+
+    void close() {
+        graphicsPage->close();
+        physicsPage->close();
+    }
+
+    // packetIds are taken from the frames
+    void write(const SPageFilePhysics& physics, const SPageFileGraphics& graphics) {
+        publish(physicsPage->data(), &physics, sizeof(physics));
+        publish(graphicsPage->data(), &graphics, sizeof(graphics));
+    }
+
+private:
+    std::unique_ptr<SharedMemoryPage> physicsPage;
+    std::unique_ptr<SharedMemoryPage> graphicsPage;
+
+    static void publish(void* page, const void* frame, size_t size) {
+        unsigned char* dst = static_cast<unsigned char*>(page);
+        const unsigned char* src = static_cast<const unsigned char*>(frame);
+        int packetId;
+        std::memcpy(&packetId, src, sizeof(packetId));
+        if (*reinterpret_cast<volatile int*>(dst) == packetId) return; // page unchanged
+        std::memcpy(dst + sizeof(int), src + sizeof(int), size - sizeof(int));
+        std::atomic_thread_fence(std::memory_order_release);
+        *reinterpret_cast<volatile int*>(dst) = packetId;
+    }
+};
@@ -1,9 +1,14 @@
 #pragma once
-#include <Windows.h>
-#include <map>
+#include "SharedMemory.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <vector>
 #include <cstdio>
-#include <cwchar>
 
 // Physics shared memory structure (truncated to what's currently used)
 struct SPageFilePhysics {
@@ -70,14 +75,16 @@ struct SPageFilePhysics {
 };
 
 // Graphics shared memory structure (truncated to what's used)
+// AC writes UTF-16 strings; char16_t keeps the layout identical off Windows
+// where wchar_t is 4 bytes.
 struct SPageFileGraphics {
     int packetId;
     int status;
     int session;
-    wchar_t currentTime[15];
-    wchar_t lastTime[15];
-    wchar_t bestTime[15];
-    wchar_t split[15];
+    char16_t currentTime[15];
+    char16_t lastTime[15];
+    char16_t bestTime[15];
+    char16_t split[15];
     int completedLaps;
     int position;
     int iCurrentTime;
@@ -89,7 +96,7 @@ struct SPageFileGraphics {
     int currentSectorIndex;
     int lastSectorTime;
     int numberOfLaps;
-    wchar_t tyreCompound[33];
+    char16_t tyreCompound[33];
     float replayTimeMultiplier;
     float normalizedCarPosition;
     float carCoordinates[3];
@@ -103,92 +110,368 @@ struct SPageFileGraphics {
     float windDirection;
 };
 
+// Producers on other platforms must match the Win32 page layout exactly
+static_assert(sizeof(SPageFilePhysics) == 580, "SPageFilePhysics layout changed");
+static_assert(sizeof(SPageFileGraphics) == 296, "SPageFileGraphics layout changed");
+
+// Lap analytics the bridge computes per sample (see LapAnalytics), laid out
+// like a page so derived tags address it the same way
+constexpr size_t acMaxSectors = 3; // further sectors are not split
+
+struct ACDerivedPage {
+    float fuelLastLap;                     // liters used in the last completed lap
+    float fuelPerLap;                      // mean over the laps completed this session
+    float fuelLapsLeft;                    // fuel / fuelPerLap
+    float deltaToBest;                     // seconds behind (+) the best lap at the same track position
+    int sectorTimes[acMaxSectors];         // this lap's completed sectors, ms (0 until done)
+    int lastLapSectorTimes[acMaxSectors];  // every sector of the last completed lap, ms
+    int bestSectorTimes[acMaxSectors];     // best time seen for each sector, ms
+    float tyreTempAvg[4];                  // rolling mean of tyreCoreTemperature per wheel
+};
+
+// Which page a field lives in
+enum class ACPage : uint8_t { Physics, Graphics, Derived };
+
+// How a field is stored in the page
+enum class ACSourceType : uint8_t { Int32, Float };
+
+// How a field is published: LapTime is milliseconds, sent as "mm:ss.mmm"
+enum class ACValueType : uint8_t { Int32, Float, LapTime };
+
+// Aggregate tags publish a statistic of every physics frame since the
+// previous sample (see Aggregator) instead of the value at sample time
+enum class ACAggregate : uint8_t { None, Min, Max, Mean, Last };
+
+// One published value: where it comes from, how it is scaled, where it goes.
+// published = source * scale + bias, truncated for Int32 outputs.
+// Array fields (count > 1) cover count consecutive 4-byte elements and are
+// written as one array variant; LapTime fields are always scalar.
+struct ACField {
+    const char* name;   // short name (display / logs)
+    const char* nodeId; // Galaxy attribute, ns=3 string identifier
+    ACPage page;
+    size_t offset;      // byte offset in the page
+    ACSourceType source;
+    ACValueType type;
+    float scale;
+    float bias;
+    uint32_t count{ 1 }; // elements
+    uint32_t slot{ 0 };  // first snapshot value, assigned by the publish plan
+    ACAggregate aggregate{ ACAggregate::None };
+};
+
+// Fields filled from the pages at sample time (not aggregates, not derived)
+inline bool acReadsPage(const ACField& f) {
+    return f.page != ACPage::Derived && f.aggregate == ACAggregate::None;
+}
+
+#define AC_PHYSICS(f) ACPage::Physics, offsetof(SPageFilePhysics, f)
+#define AC_GRAPHICS(f) ACPage::Graphics, offsetof(SPageFileGraphics, f)
+
+// Built-in mapping (the original Galaxy attributes); a tag map file replaces it
+constexpr ACField acDefaultFields[] = {
+    { "speedKmh",      "719:Car.speed",       AC_PHYSICS(speedKmh),   ACSourceType::Float, ACValueType::Int32, 1.0f, 0.0f },
+    { "engineRPM",     "719:Car.rpm",         AC_PHYSICS(engineRPM),  ACSourceType::Int32, ACValueType::Int32, 1.0f, 0.0f },
+    { "fuel",          "719:Car.fuel",        AC_PHYSICS(fuel),       ACSourceType::Float, ACValueType::Int32, 1.0f, 0.0f },
+    { "steerAngle",    "719:Car.steerAngle",  AC_PHYSICS(steerAngle), ACSourceType::Float, ACValueType::Int32, 100.0f, 0.0f },
+    { "gear",          "719:Car.currentGear", AC_PHYSICS(gear),       ACSourceType::Int32, ACValueType::Int32, 1.0f, -1.0f }, // human gear (N=0)
+    { "gas",           "719:Car.gas",         AC_PHYSICS(gas),        ACSourceType::Float, ACValueType::Int32, 100.0f, 0.0f },
+    { "brake",         "719:Car.brake",       AC_PHYSICS(brake),      ACSourceType::Float, ACValueType::Int32, 100.0f, 0.0f },
+    { "currentTime",   "723:GameEnviroment.currentTime",   AC_GRAPHICS(iCurrentTime),  ACSourceType::Int32, ACValueType::LapTime, 1.0f, 0.0f },
+    { "lastTime",      "723:GameEnviroment.lastTime",      AC_GRAPHICS(iLastTime),     ACSourceType::Int32, ACValueType::LapTime, 1.0f, 0.0f },
+    { "bestTime",      "723:GameEnviroment.bestTime",      AC_GRAPHICS(iBestTime),     ACSourceType::Int32, ACValueType::LapTime, 1.0f, 0.0f },
+    { "numberOfLaps",  "723:GameEnviroment.numberOfLaps",  AC_GRAPHICS(numberOfLaps),  ACSourceType::Int32, ACValueType::Int32, 1.0f, 0.0f },
+    { "position",      "723:GameEnviroment.position",      AC_GRAPHICS(position),      ACSourceType::Int32, ACValueType::Int32, 1.0f, 0.0f },
+    { "completedLaps", "723:GameEnviroment.completedLaps", AC_GRAPHICS(completedLaps), ACSourceType::Int32, ACValueType::Int32, 1.0f, 0.0f },
+    { "windSpeed",     "723:GameEnviroment.windSpeed",     AC_GRAPHICS(windSpeed),     ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f },
+    { "windDirection", "723:GameEnviroment.windDirection", AC_GRAPHICS(windDirection), ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f },
+    // Per-wheel arrays (FL, FR, RL, RR); tyreContactPoint is x,y,z per wheel
+    { "tyreCoreTemperature", "719:Car.tyreCoreTemperature", AC_PHYSICS(tyreCoreTemperature), ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 4 },
+    { "tyreTempI",        "719:Car.tyreTempI",        AC_PHYSICS(tyreTempI),        ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 4 },
+    { "tyreTempM",        "719:Car.tyreTempM",        AC_PHYSICS(tyreTempM),        ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 4 },
+    { "tyreTempO",        "719:Car.tyreTempO",        AC_PHYSICS(tyreTempO),        ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 4 },
+    { "wheelSlip",        "719:Car.wheelSlip",        AC_PHYSICS(wheelSlip),        ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 4 },
+    { "wheelLoad",        "719:Car.wheelLoad",        AC_PHYSICS(wheelLoad),        ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 4 },
+    { "brakeTemp",        "719:Car.brakeTemp",        AC_PHYSICS(brakeTemp),        ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 4 },
+    { "suspensionTravel", "719:Car.suspensionTravel", AC_PHYSICS(suspensionTravel), ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 4 },
+    { "tyreContactPoint", "719:Car.tyreContactPoint", AC_PHYSICS(tyreContactPoint), ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 12 },
+};
+
+#undef AC_PHYSICS
+#undef AC_GRAPHICS
+
+constexpr size_t acDefaultFieldCount = sizeof(acDefaultFields) / sizeof(acDefaultFields[0]);
+
+// Upper bound on published values per snapshot (fixed so snapshots stay
+// flat; copies only move the values in use, see ACSharedOutData)
+constexpr size_t ACMaxValues = 4096;
+
+// One 4-byte copy from a page into the raw snapshot
+struct ACCopyOp {
+    uint32_t offset; // byte offset in the page
+    uint32_t index;  // snapshot value index
+};
+
+// Snapshot values used by a field table (fields are laid out by slot)
+inline size_t acValueCount(const ACField* table, size_t count) {
+    size_t n = 0;
+    for (size_t k = 0; k < count; ++k)
+        if (table[k].slot + table[k].count > n) n = table[k].slot + table[k].count;
+    return n;
+}
+
+// Int32 and LapTime fields use i, Float fields use f
+union ACValue {
+    int32_t i;
+    float f;
+};
+static_assert(sizeof(ACValue) == 4, "array fields are published straight from ACValue runs");
+
+// Counters for consistent-snapshot mode
+// (atomic: written by the sampling thread, read by the display)
+struct ACReadStats {
+    std::atomic<uint64_t> reads{ 0 };   // page reads attempted
+    std::atomic<uint64_t> retries{ 0 }; // re-reads because packetId moved during the copy
+    std::atomic<uint64_t> torn{ 0 };    // reads that never settled within maxReadRetries
+};
+
+// Flat snapshot, field k of the active field table owns
+// values[slot .. slot + count). Copies carry the first count values only:
+// a plan uses a few dozen of the ACMaxValues slots, and snapshots are copied
+// through every ring on the hot path. Values past count are unspecified in
+// a copy and never read.
 struct ACSharedOutData {
-    std::map<std::string, int> vehicle; // integer values (converted / truncated)
-    std::map<std::string, std::string> times;
-    std::map<std::string, int> env;
-    std::map<std::string, float> miscFloats; // string times (formatted)
+    ACValue values[ACMaxValues];
+    uint32_t count{ 0 }; // values in use
+    int physicsPacketId{ 0 };
+    int graphicsPacketId{ 0 };
+    int64_t sampledNs{ 0 }; // steady_clock time of the read
+    int64_t sampledUtcNs{ 0 }; // system_clock time of the read, sent as the source timestamp
+    bool consistent{ true }; // false if a page was still changing after all retries
     bool ok{ false }; // indicates read success
+
+    ACSharedOutData() { std::memset(values, 0, sizeof(values)); }
+    ACSharedOutData(const ACSharedOutData& other) { copyFrom(other); }
+    ACSharedOutData& operator=(const ACSharedOutData& other) {
+        if (this != &other) copyFrom(other);
+        return *this;
+    }
+
+    int32_t i(size_t k) const { return values[k].i; }
+    float f(size_t k) const { return values[k].f; }
+
+private:
+    void copyFrom(const ACSharedOutData& other) {
+        // A ring may copy from a slot being rewritten (and discard the copy),
+        // so count is bounded before use
+        uint32_t n = other.count < ACMaxValues ? other.count : static_cast<uint32_t>(ACMaxValues);
+        std::memcpy(values, other.values, n * sizeof(ACValue));
+        count = n;
+        physicsPacketId = other.physicsPacketId;
+        graphicsPacketId = other.graphicsPacketId;
+        sampledNs = other.sampledNs;
+        sampledUtcNs = other.sampledUtcNs;
+        consistent = other.consistent;
+        ok = other.ok;
+    }
 };
 
+// "mm:ss.mmm" into a caller buffer (at least 16 chars); returns the length
+inline size_t formatLapTime(int ms, char* buf, size_t size) {
+    if (ms <= 0) return static_cast<size_t>(std::snprintf(buf, size, "--:--.---"));
+    int minutes = ms / 60000;
+    int seconds = (ms % 60000) / 1000;
+    int millis = ms % 1000;
+    return static_cast<size_t>(std::snprintf(buf, size, "%02d:%02d.%03d", minutes, seconds, millis));
+}
+
 class ACSharedOut {
 public:
-    ACSharedOut() {}
+    ACSharedOut()
+        : physicsView(makeSharedMemoryView()), graphicsView(makeSharedMemoryView()) {}
     ~ACSharedOut() { cleanup(); }
 
-    bool initialize() {
+    // mapping is the page name stem: <mapping>_physics and <mapping>_graphics.
+    // The game uses "acpmf"; other names serve rigs relayed onto one host.
+    bool initialize(const std::string& mapping = "acpmf") {
         // Open physics mapping
-        hMapFilePhysics = OpenFileMappingW(FILE_MAP_READ, FALSE, L"Local\\acpmf_physics");
-        if (!hMapFilePhysics) return false;
-
-        acPhysics = static_cast<SPageFilePhysics*>(
-            MapViewOfFile(hMapFilePhysics, FILE_MAP_READ, 0, 0, sizeof(SPageFilePhysics)));
-        if (!acPhysics) { cleanup(); return false; }
+        if (!physicsView->open(mapping + "_physics", sizeof(SPageFilePhysics))) return false;
+        acPhysics = static_cast<const SPageFilePhysics*>(physicsView->data());
 
         // Open graphics mapping
-        hMapFileGraphics = OpenFileMappingW(FILE_MAP_READ, FALSE, L"Local\\acpmf_graphics");
-        if (!hMapFileGraphics) { cleanup(); return false; }
-
-        acGraphics = static_cast<SPageFileGraphics*>(
-            MapViewOfFile(hMapFileGraphics, FILE_MAP_READ, 0, 0, sizeof(SPageFileGraphics)));
-        if (!acGraphics) { cleanup(); return false; }
+        if (!graphicsView->open(mapping + "_graphics", sizeof(SPageFileGraphics))) { cleanup(); return false; }
+        acGraphics = static_cast<const SPageFileGraphics*>(graphicsView->data());
 
         connected = true;
         return true;
     }
 
     void cleanup() {
-        if (acGraphics) { UnmapViewOfFile(acGraphics); acGraphics = nullptr; }
-        if (hMapFileGraphics) { CloseHandle(hMapFileGraphics); hMapFileGraphics = nullptr; }
-        if (acPhysics) { UnmapViewOfFile(acPhysics); acPhysics = nullptr; }
-        if (hMapFilePhysics) { CloseHandle(hMapFilePhysics); hMapFilePhysics = nullptr; }
+        graphicsView->close(); acGraphics = nullptr;
+        physicsView->close(); acPhysics = nullptr;
         connected = false;
     }
 
+    // Field table readInto() fills snapshots from (usually PublishPlan::fields());
+    // must outlive this object. Compiled here into per-page copy lists so
+    // reads do no lookups. Nothing is read until this is called.
+    bool setFields(const ACField* table, size_t count) {
+        for (size_t k = 0; k < count; ++k) {
+            const ACField& f = table[k];
+            if (f.slot + f.count > ACMaxValues) return false;
+            size_t pageSize = f.page == ACPage::Physics ? sizeof(SPageFilePhysics)
+                : f.page == ACPage::Graphics ? sizeof(SPageFileGraphics) : sizeof(ACDerivedPage);
+            if (f.count == 0 || f.offset + f.count * sizeof(uint32_t) > pageSize) return false;
+        }
+        fields = table;
+        fieldCount = count;
+        valueCount = acValueCount(table, count);
+        rawValues.assign(valueCount, 0);
+        physicsOps.clear();
+        graphicsOps.clear();
+        for (size_t k = 0; k < count; ++k) {
+            if (!acReadsPage(table[k])) continue; // filled by the Aggregator or LapAnalytics
+            for (uint32_t e = 0; e < table[k].count; ++e) {
+                ACCopyOp op{ static_cast<uint32_t>(table[k].offset + e * sizeof(uint32_t)), table[k].slot + e };
+                (table[k].page == ACPage::Physics ? physicsOps : graphicsOps).push_back(op);
+            }
+        }
+        return true;
+    }
+
+    // Consistent mode treats each page's packetId as a sequence counter:
+    // copy the used fields, re-check packetId and retry if AC moved on
+    // meanwhile. Direct mode reads straight from the live pages.
+    void setConsistentReads(bool enabled) { consistentReads = enabled; }
+    const ACReadStats& readStats() const { return stats; }
+
+    // Cheap poll for a new physics frame, no snapshot taken
+    int physicsPacketId() const {
+        return acPhysics ? loadPacketId(reinterpret_cast<const unsigned char*>(acPhysics)) : 0;
+    }
+
+    // Whole-page copies for the recorder, packetId-checked like readGame()
+    // but without touching readStats(). False if either page never settled.
+    bool readPages(SPageFilePhysics& physics, SPageFileGraphics& graphics) const {
+        if (!connected || !acPhysics || !acGraphics) return false;
+        bool physOk = copyPage(reinterpret_cast<const unsigned char*>(acPhysics), &physics, sizeof(physics));
+        bool gfxOk = copyPage(reinterpret_cast<const unsigned char*>(acGraphics), &graphics, sizeof(graphics));
+        return physOk && gfxOk;
+    }
+
     ACSharedOutData readGame() {
         ACSharedOutData data;
-        if (!connected || !acPhysics || !acGraphics) return data; // ok stays false
-
-        // Vehicle numeric/int-like values (truncate where float)
-        data.vehicle["speedKmh"] = acPhysics->speedKmh;
-        data.vehicle["engineRPM"] = acPhysics->engineRPM;
-        data.vehicle["gear"] = acPhysics->gear - 1; // convert to human (N=0)
-        data.vehicle["fuel"] = acPhysics->fuel;
-        data.vehicle["steerAngle"] = acPhysics->steerAngle * 100;
-        data.vehicle["gas"] = acPhysics->gas * 100;
-        data.vehicle["brake"] = acPhysics->brake * 100;
-
-        // Laps / session numeric values
-        data.env["numberOfLaps"] = acGraphics->numberOfLaps;
-        data.env["position"] = acGraphics->position;
-        data.env["completedLaps"] = acGraphics->completedLaps;
-
-        data.miscFloats["windSpeed"] = acGraphics->windSpeed;
-        data.miscFloats["windDirection"] = acGraphics->windDirection;
-
-        // Format all times consistently as strings
-        data.times["currentTime"] = formatTime(acGraphics->iCurrentTime);
-        data.times["lastTime"] = formatTime(acGraphics->iLastTime);
-        data.times["bestTime"] = formatTime(acGraphics->iBestTime);
+        readInto(data);
+        return data;
+    }
+
+    // Fills only this source's slots of data, so several sources with
+    // disjoint field tables can share one snapshot. packetIds, read times,
+    // consistent and ok describe this read; count never shrinks.
+    bool readInto(ACSharedOutData& data) {
+        data.ok = false;
+        if (!connected || !acPhysics || !acGraphics) return false;
+
+        // Raw 4-byte field images, converted below once both pages are in
+        uint32_t* raw = rawValues.data();
+        const unsigned char* physics = reinterpret_cast<const unsigned char*>(acPhysics);
+        const unsigned char* graphics = reinterpret_cast<const unsigned char*>(acGraphics);
+        if (consistentReads) {
+            bool physOk = readStable(physics, physicsOps, data.physicsPacketId, raw);
+            bool gfxOk = readStable(graphics, graphicsOps, data.graphicsPacketId, raw);
+            data.consistent = physOk && gfxOk;
+        }
+        else {
+            data.consistent = true;
+            data.physicsPacketId = acPhysics->packetId;
+            data.graphicsPacketId = acGraphics->packetId;
+            copyFields(physics, physicsOps, raw);
+            copyFields(graphics, graphicsOps, raw);
+        }
+
+        for (size_t k = 0; k < fieldCount; ++k) {
+            const ACField& f = fields[k];
+            if (!acReadsPage(f)) continue;
+            for (uint32_t v = f.slot; v < f.slot + f.count; ++v)
+                data.values[v] = convert(f, raw[v]);
+        }
+        if (valueCount > data.count) data.count = static_cast<uint32_t>(valueCount);
+
+        data.sampledNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        data.sampledUtcNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
 
         data.ok = true;
-        return data;
+        return true;
     }
 
 private:
-    HANDLE hMapFilePhysics{ nullptr };
-    HANDLE hMapFileGraphics{ nullptr };
-    SPageFilePhysics* acPhysics{ nullptr };
-    SPageFileGraphics* acGraphics{ nullptr };
+    std::unique_ptr<SharedMemoryView> physicsView;
+    std::unique_ptr<SharedMemoryView> graphicsView;
+    const SPageFilePhysics* acPhysics{ nullptr };
+    const SPageFileGraphics* acGraphics{ nullptr };
     bool connected{ false };
+    bool consistentReads{ true };
+    const ACField* fields{ nullptr };
+    size_t fieldCount{ 0 };
+    size_t valueCount{ 0 };
+    std::vector<ACCopyOp> physicsOps;
+    std::vector<ACCopyOp> graphicsOps;
+    std::vector<uint32_t> rawValues; // readInto() scratch, valueCount entries
+    ACReadStats stats;
+
+    static const int maxReadRetries = 8;
+
+    static void copyFields(const unsigned char* base, const std::vector<ACCopyOp>& ops, uint32_t* raw) {
+        for (const ACCopyOp& op : ops)
+            std::memcpy(&raw[op.index], base + op.offset, sizeof(uint32_t));
+    }
+
+    static ACValue convert(const ACField& field, uint32_t bits) {
+        double src;
+        if (field.source == ACSourceType::Int32) { int32_t v; std::memcpy(&v, &bits, sizeof(v)); src = v; }
+        else { float v; std::memcpy(&v, &bits, sizeof(v)); src = v; }
+        double scaled = src * field.scale + field.bias;
+
+        ACValue out;
+        if (field.type == ACValueType::Float) out.f = static_cast<float>(scaled);
+        else out.i = static_cast<int32_t>(scaled);
+        return out;
+    }
+
+    static int loadPacketId(const unsigned char* base) {
+        // packetId is the first member of both pages
+        return *reinterpret_cast<const volatile int*>(base);
+    }
+
+    static bool copyPage(const unsigned char* base, void* out, size_t size) {
+        for (int attempt = 0; attempt <= maxReadRetries; ++attempt) {
+            int before = loadPacketId(base);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            std::memcpy(out, base, size);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (loadPacketId(base) == before) return true;
+        }
+        return false;
+    }
 
-    std::string formatTime(int ms) {
-        if (ms <= 0) return "--:--.---";
-        int minutes = ms / 60000;
-        int seconds = (ms % 60000) / 1000;
-        int millis = ms % 1000;
-        char buf[16];
-        std::snprintf(buf, sizeof(buf), "%02d:%02d.%03d", minutes, seconds, millis);
-        return std::string(buf);
+    // Seqlock-style read: the copy is accepted only if packetId was the same
+    // before and after it. AC does not publish an "in progress" marker, so
+    // this catches every copy that straddles a packet change, not a write
+    // that is still in flight when both checks see the old id.
+    bool readStable(const unsigned char* base, const std::vector<ACCopyOp>& ops, int& packetId, uint32_t* raw) {
+        ++stats.reads;
+        for (int attempt = 0; attempt <= maxReadRetries; ++attempt) {
+            int before = loadPacketId(base);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            copyFields(base, ops, raw);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            packetId = loadPacketId(base);
+            if (packetId == before) return true;
+            if (attempt < maxReadRetries) ++stats.retries;
+        }
+        ++stats.torn;
+        return false;
     }
 };
@@ -0,0 +1,176 @@
+#pragma once
+#include "ACSharedOut.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Computes the aggregate tags of a plan (min, max, mean, last) from every
+// physics frame, not just the ones the publish period happens to sample,
+// so brake spikes and rpm peaks between publishes still reach Galaxy.
+// A thread polls each rig's physics packetId and folds every new frame into
+// per-input accumulators kept as flat arrays (one loop per statistic over
+// all inputs, which the compiler vectorizes). take() copies the interval's
+// results into a sample's aggregate slots and starts the next interval.
+class Aggregator {
+public:
+    ~Aggregator() { stop(); }
+
+    // Aggregate tags of table (one rig's share of the plan, read from the
+    // pages at mapping). Tags without one are ignored; before start().
+    bool add(const std::string& mapping, const ACField* table, size_t count, bool consistentReads) {
+        std::unique_ptr<Rig> rig(new Rig());
+        for (size_t k = 0; k < count; ++k) {
+            const ACField& f = table[k];
+            if (f.aggregate == ACAggregate::None) continue;
+            rig->outputs.push_back(Output{ &f, input(*rig, f) });
+        }
+        if (rig->outputs.empty()) return true;
+
+        if (!rig->ac.initialize(mapping)) {
+            std::cerr << "Aggregator cannot open shared memory " << mapping << "\n";
+            return false;
+        }
+        rig->ac.setConsistentReads(consistentReads);
+        if (!rig->ac.setFields(rig->inputs.data(), rig->inputs.size())) return false;
+        size_t n = acValueCount(rig->inputs.data(), rig->inputs.size());
+        rig->frame.resize(n);
+        rig->lo.resize(n);
+        rig->hi.resize(n);
+        rig->sum.resize(n);
+        rig->last.assign(n, 0.0f);
+        reset(*rig);
+        rigs.push_back(std::move(rig));
+        return true;
+    }
+
+    bool empty() const { return rigs.empty(); }
+    uint64_t frames() const { return frameCount.load(std::memory_order_relaxed); }
+
+    void start() {
+        if (rigs.empty()) return;
+        running = true;
+        worker = std::thread([this] { run(); });
+    }
+
+    void stop() {
+        running = false;
+        if (worker.joinable()) worker.join();
+    }
+
+    // Sampler thread: the statistics since the previous take() into the
+    // aggregate slots of snap. An interval without frames repeats the last one.
+    void take(ACSharedOutData& snap) {
+        for (auto& r : rigs) {
+            Rig& rig = *r;
+            std::lock_guard<std::mutex> lock(rig.mutex);
+            for (const Output& out : rig.outputs) {
+                const ACField& f = *out.field;
+                for (uint32_t e = 0; e < f.count; ++e) {
+                    size_t i = out.input + e;
+                    float v;
+                    switch (f.aggregate) {
+                    case ACAggregate::Min: v = rig.samples ? rig.lo[i] : rig.last[i]; break;
+                    case ACAggregate::Max: v = rig.samples ? rig.hi[i] : rig.last[i]; break;
+                    case ACAggregate::Mean: v = rig.samples ? static_cast<float>(rig.sum[i] / rig.samples) : rig.last[i]; break;
+                    default: v = rig.last[i]; break;
+                    }
+                    if (f.type == ACValueType::Float) snap.values[f.slot + e].f = v;
+                    else snap.values[f.slot + e].i = static_cast<int32_t>(v);
+                }
+            }
+            reset(rig);
+        }
+    }
+
+private:
+    struct Output {
+        const ACField* field;
+        size_t input; // first accumulator
+    };
+
+    struct Rig {
+        ACSharedOut ac;
+        std::vector<ACField> inputs; // distinct sources of the outputs, read as Float
+        std::vector<Output> outputs;
+        ACSharedOutData snap;        // worker thread only
+        std::vector<float> frame;    // worker thread only
+        int lastPacketId{ 0 };
+        bool hasLast{ false };
+        std::mutex mutex;            // guards the accumulators
+        std::vector<float> lo;
+        std::vector<float> hi;
+        std::vector<double> sum;
+        std::vector<float> last;
+        uint64_t samples{ 0 };
+    };
+
+    std::vector<std::unique_ptr<Rig>> rigs;
+    std::atomic<bool> running{ false };
+    std::atomic<uint64_t> frameCount{ 0 };
+    std::thread worker;
+
+    // Accumulator index for f's source, shared by tags on the same source
+    static size_t input(Rig& rig, const ACField& f) {
+        for (const ACField& in : rig.inputs)
+            if (in.page == f.page && in.offset == f.offset && in.count == f.count && in.source == f.source &&
+                in.scale == f.scale && in.bias == f.bias) return in.slot;
+        ACField in = f;
+        in.type = ACValueType::Float;
+        in.aggregate = ACAggregate::None;
+        in.slot = static_cast<uint32_t>(acValueCount(rig.inputs.data(), rig.inputs.size()));
+        rig.inputs.push_back(in);
+        return in.slot;
+    }
+
+    static void reset(Rig& rig) {
+        std::fill(rig.lo.begin(), rig.lo.end(), std::numeric_limits<float>::max());
+        std::fill(rig.hi.begin(), rig.hi.end(), std::numeric_limits<float>::lowest());
+        std::fill(rig.sum.begin(), rig.sum.end(), 0.0);
+        rig.samples = 0;
+    }
+
+    static void accumulate(Rig& rig) {
+        const size_t n = rig.frame.size();
+        const float* x = rig.frame.data();
+        float* lo = rig.lo.data();
+        float* hi = rig.hi.data();
+        double* sum = rig.sum.data();
+        std::lock_guard<std::mutex> lock(rig.mutex);
+        for (size_t i = 0; i < n; ++i) lo[i] = x[i] < lo[i] ? x[i] : lo[i];
+        for (size_t i = 0; i < n; ++i) hi[i] = x[i] > hi[i] ? x[i] : hi[i];
+        for (size_t i = 0; i < n; ++i) sum[i] += x[i];
+        std::memcpy(rig.last.data(), x, n * sizeof(float));
+        ++rig.samples;
+    }
+
+    void run() {
+        while (running.load(std::memory_order_relaxed)) {
+            bool any = false;
+            for (auto& r : rigs) {
+                Rig& rig = *r;
+                if (rig.hasLast && rig.ac.physicsPacketId() == rig.lastPacketId) continue;
+                if (!rig.ac.readInto(rig.snap)) continue;
+                if (rig.hasLast && rig.snap.physicsPacketId == rig.lastPacketId) continue;
+                rig.lastPacketId = rig.snap.physicsPacketId;
+                rig.hasLast = true;
+                std::memcpy(rig.frame.data(), rig.snap.values, rig.frame.size() * sizeof(float));
+                accumulate(rig);
+                frameCount.fetch_add(1, std::memory_order_relaxed);
+                any = true;
+            }
+            // Physics frames are ~3 ms apart; polling at well under that
+            // misses none of them
+            if (!any) std::this_thread::sleep_for(std::chrono::microseconds(250));
+        }
+    }
+};
@@ -0,0 +1,39 @@
+#include "AllocCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+// Replacement global new/delete that only count; storage still comes from malloc.
+// Per thread: a plain integer, constant-initialized, so safe from any thread.
+static thread_local uint64_t allocCount = 0;
+
+uint64_t heapAllocations() {
+    return allocCount;
+}
+
+void* operator new(std::size_t size) {
+    ++allocCount;
+    if (size == 0) size = 1;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+// Number of global operator new calls made by the calling thread since it
+// started, so a publish loop's count is not muddied by the sampler, the
+// status screen or other endpoints. Allocations made by open62541
+// (UA_malloc) are not included.
+uint64_t heapAllocations();
@@ -0,0 +1,174 @@
+#pragma once
+#include <open62541/client.h>
+#include "LatencyHistogram.h"
+#include "PreparedWrite.h"
+#include "SampleStore.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+struct AsyncWriteStats {
+    uint64_t sent{ 0 };           // requests handed to the client
+    uint64_t acked{ 0 };          // responses with a good service result
+    uint64_t failedRequests{ 0 }; // bad service result, timeout or send error
+    uint64_t failedItems{ 0 };    // bad per-item results in otherwise good responses
+    uint64_t stored{ 0 };         // samples handed to the store because the link went down
+    int64_t lastAgeUs{ 0 };       // sample-to-acknowledgement time of the last good response
+};
+
+// Keeps up to `window` write requests in flight instead of waiting a full
+// round trip per cycle. Each slot remembers the sample it carried and which
+// fields were in it, so responses (which arrive from UA_Client_run_iterate)
+// are matched back to their sample and per-item errors name the right tag.
+// Slots also keep the sample's values: a request that cannot be sent, or
+// dies in flight with the connection, goes to the store set by setStore()
+// for backfill instead of being lost.
+// Single-threaded: call from the thread that services the client.
+class AsyncWriter {
+public:
+    AsyncWriter(size_t window, size_t fieldCount, size_t valueCount)
+        : slots(window == 0 ? 1 : window), values(valueCount) {
+        for (auto& slot : slots) {
+            slot.owner = this;
+            slot.fields.resize(fieldCount);
+            slot.values.resize(valueCount);
+        }
+    }
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    bool full() const { return inFlightCount == slots.size(); }
+    size_t inFlight() const { return inFlightCount; }
+    const AsyncWriteStats& stats() const { return writeStats; }
+    void setAgeHistogram(LatencyHistogram* histogram) { ages = histogram; } // sample-to-acknowledgement, per response
+    void setStore(SampleStore* sampleStore) { store = sampleStore; }       // where samples lost with the link go
+
+    // Send the writer's selected payloads for snap. Nothing selected is a
+    // no-op; returns false if no slot is free or the send fails.
+    bool send(UA_Client* client, PreparedWrite& writer, const ACSharedOutData& snap) {
+        if (writer.selected() == 0) return true;
+        Slot* slot = freeSlot();
+        if (!slot) return false;
+
+        slot->packetId = snap.physicsPacketId;
+        slot->graphicsPacketId = snap.graphicsPacketId;
+        slot->sampledNs = snap.sampledNs;
+        slot->sampledUtcNs = snap.sampledUtcNs;
+        std::memcpy(slot->values.data(), snap.values, values * sizeof(ACValue));
+        slot->count = writer.selected();
+        for (size_t i = 0; i < slot->count; ++i) slot->fields[i] = writer.selectedField(i);
+        slot->writer = &writer;
+
+        // Mark busy first in case the client answers from inside the call
+        slot->busy = true;
+        ++inFlightCount;
+        UA_StatusCode sc = writer.sendAsync(client, onResponse, slot, &slot->requestId);
+        if (sc != UA_STATUSCODE_GOOD) {
+            if (slot->busy) { slot->busy = false; --inFlightCount; }
+            std::cerr << "Async write send failed: status=0x" << std::hex << (unsigned)sc << std::dec << "\n";
+            ++writeStats.failedRequests;
+            ++failuresPending;
+            keep(*slot); // never left this host
+            return false;
+        }
+        ++writeStats.sent;
+        return true;
+    }
+
+    // Service the client until every request is answered or timeoutMs passes
+    void drain(UA_Client* client, int timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (inFlightCount > 0 && std::chrono::steady_clock::now() < deadline)
+            UA_Client_run_iterate(client, 10);
+    }
+
+    // Failed requests since the last call (e.g. to resend change-only values)
+    uint64_t takeFailures() {
+        uint64_t n = failuresPending;
+        failuresPending = 0;
+        return n;
+    }
+
+private:
+    struct Slot {
+        AsyncWriter* owner{ nullptr };
+        PreparedWrite* writer{ nullptr };
+        bool busy{ false };
+        UA_UInt32 requestId{ 0 };
+        int packetId{ 0 };
+        int graphicsPacketId{ 0 };
+        int64_t sampledNs{ 0 };
+        int64_t sampledUtcNs{ 0 };
+        size_t count{ 0 };
+        std::vector<size_t> fields;  // field index per request entry, sized once
+        std::vector<ACValue> values; // the sample, for the store
+    };
+
+    std::vector<Slot> slots;
+    size_t values;
+    SampleStore* store{ nullptr };
+    ACSharedOutData scratch;
+    size_t inFlightCount{ 0 };
+    uint64_t failuresPending{ 0 };
+    AsyncWriteStats writeStats;
+    LatencyHistogram* ages{ nullptr };
+
+    // Hands the slot's sample to the store, whole: the backfill writes every field
+    void keep(const Slot& slot) {
+        if (!store) return;
+        std::memcpy(scratch.values, slot.values.data(), values * sizeof(ACValue));
+        scratch.count = static_cast<uint32_t>(values);
+        scratch.physicsPacketId = slot.packetId;
+        scratch.graphicsPacketId = slot.graphicsPacketId;
+        scratch.sampledNs = slot.sampledNs;
+        scratch.sampledUtcNs = slot.sampledUtcNs;
+        scratch.ok = true;
+        store->push(scratch);
+        ++writeStats.stored;
+    }
+
+    Slot* freeSlot() {
+        for (auto& slot : slots)
+            if (!slot.busy) return &slot;
+        return nullptr;
+    }
+
+    static void onResponse(UA_Client*, void* userdata, UA_UInt32, UA_WriteResponse* resp) {
+        Slot* slot = static_cast<Slot*>(userdata);
+        slot->owner->complete(*slot, *resp);
+    }
+
+    void complete(Slot& slot, const UA_WriteResponse& resp) {
+        slot.busy = false;
+        --inFlightCount;
+
+        if (resp.responseHeader.serviceResult != UA_STATUSCODE_GOOD || resp.resultsSize != slot.count) {
+            std::cerr << "Async write for packet " << slot.packetId << " failed: status=0x" << std::hex
+                << (unsigned)resp.responseHeader.serviceResult << std::dec << "\n";
+            ++writeStats.failedRequests;
+            ++failuresPending;
+            if (linkLost(resp.responseHeader.serviceResult)) keep(slot);
+            return;
+        }
+
+        bool itemFailed = false;
+        for (size_t i = 0; i < resp.resultsSize; ++i) {
+            if (resp.results[i] == UA_STATUSCODE_GOOD) continue;
+            std::cerr << "Async write failed at " << i << " (ns=3;s:" << slot.writer->nodeName(slot.fields[i])
+                << ") status=0x" << std::hex << (unsigned)resp.results[i] << std::dec << "\n";
+            ++writeStats.failedItems;
+            itemFailed = true;
+        }
+        if (itemFailed) ++failuresPending;
+
+        ++writeStats.acked;
+        int64_t ageNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count() - slot.sampledNs;
+        writeStats.lastAgeUs = ageNs / 1000;
+        if (ages) ages->record(ageNs);
+    }
+};
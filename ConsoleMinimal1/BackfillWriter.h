@@ -0,0 +1,198 @@
+#pragma once
+#include <open62541/client.h>
+#include "ACSharedOut.h"
+#include "PreparedWrite.h"
+#include "SampleStore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Drains a SampleStore after an outage: up to batchSamples stored samples
+// per WriteRequest, oldest first (one WriteValue per field and sample), and
+// no more than samplesPerSecond on average, so live writes keep their
+// share of the link. Storage and variants are prepared once like
+// PreparedWrite. Batches go out asynchronously, one at a time: step() never
+// waits for the server, the response comes in through UA_Client_run_iterate
+// like the live writes'. A batch lost with the connection stays pending and
+// is sent again before anything else is taken from the store. One the
+// server refuses (too many operations, request too large) is retried in
+// halves, and later batches stay at the smaller size; after MaxAttempts
+// refusals in a row, or a timeout (it may have been applied), the pending
+// samples are dropped and counted in failedBatches().
+class BackfillWriter {
+public:
+    BackfillWriter() { UA_WriteRequest_init(&req); }
+    ~BackfillWriter() { clear(); }
+
+    static constexpr int MaxAttempts = 5;
+
+    BackfillWriter(const BackfillWriter&) = delete;
+    BackfillWriter& operator=(const BackfillWriter&) = delete;
+
+    bool build(const ACField* table, size_t count, size_t batchSamples, double samplesPerSecond) {
+        clear();
+        fields = table;
+        fieldCount = count;
+        batchCap = batchSamples ? batchSamples : 1;
+        limit = batchCap;
+        rate = samplesPerSecond > 0 ? samplesPerSecond : 1;
+        valueCount = acValueCount(table, count);
+        values.assign(batchCap * valueCount, ACValue());
+        times.resize(batchCap * count);
+        writeValues.resize(batchCap * count);
+        for (size_t s = 0; s < batchCap; ++s) {
+            for (size_t k = 0; k < count; ++k) {
+                UA_WriteValue& w = writeValues[s * count + k];
+                UA_WriteValue_init(&w);
+                w.attributeId = UA_ATTRIBUTEID_VALUE;
+                w.value.hasValue = true;
+                w.value.hasSourceTimestamp = stamped;
+                bindWriteValue(w, fields[k], &values[s * valueCount], times[s * count + k]);
+            }
+        }
+        return true;
+    }
+
+    // As PreparedWrite::setSourceTimestamps(); before build(). Backfilled
+    // values are only placed correctly in history with timestamps on.
+    void setSourceTimestamps(bool on) { stamped = on; }
+
+    // Takes the ids the live writer uses; call after build() and after
+    // every PreparedWrite::resolveNodeIds()
+    bool setNodeIds(const PreparedWrite& live) {
+        for (size_t s = 0; s < batchCap; ++s) {
+            for (size_t k = 0; k < fieldCount; ++k) {
+                UA_NodeId& id = writeValues[s * fieldCount + k].nodeId;
+                UA_NodeId_clear(&id);
+                if (UA_NodeId_copy(&live.nodeId(k), &id) != UA_STATUSCODE_GOOD) return false;
+            }
+        }
+        return true;
+    }
+
+    // Sends one request if the rate allows and none is in flight: the
+    // pending samples, at most limit of them. Returns false when the request
+    // could not be sent (the batch is kept for the next call).
+    bool step(UA_Client* client, SampleStore& store) {
+        auto now = std::chrono::steady_clock::now();
+        if (hasRefill) tokens = std::min(static_cast<double>(batchCap),
+            tokens + rate * std::chrono::duration<double>(now - lastRefill).count());
+        lastRefill = now;
+        hasRefill = true;
+
+        if (inFlight) return true;
+        if (batched == 0) {
+            size_t want = std::min(limit, store.size());
+            if (want == 0 || tokens < static_cast<double>(want)) return true;
+            while (batched < want && store.pop(scratch)) fill(batched++, scratch);
+            if (batched == 0) return true;
+        }
+        sending = std::min(limit, batched - first);
+        if (tokens < static_cast<double>(sending)) return true;
+
+        req.nodesToWrite = writeValues.data() + first * fieldCount;
+        req.nodesToWriteSize = sending * fieldCount;
+        UA_UInt32 requestId = 0;
+        inFlight = true; // in case the client answers from inside the call
+        UA_StatusCode sc = UA_Client_sendAsyncWriteRequest(client, &req, onResponse, this, &requestId);
+        if (sc != UA_STATUSCODE_GOOD) {
+            inFlight = false;
+            std::cerr << "Backfill write of " << sending << " samples could not be sent: status=0x" << std::hex
+                << (unsigned)sc << std::dec << "\n";
+            return false;
+        }
+        tokens -= static_cast<double>(sending);
+        return true;
+    }
+
+    size_t pending() const { return batched - first; } // samples taken from the store, not yet acknowledged
+    bool busy() const { return inFlight; }
+    uint64_t sent() const { return sentCount; }
+    uint64_t failedBatches() const { return failedCount; } // dropped after refusals or a timeout
+
+    void clear() {
+        for (auto& w : writeValues) UA_NodeId_clear(&w.nodeId);
+        writeValues.clear();
+        values.clear();
+        times.clear();
+        UA_WriteRequest_init(&req);
+        fields = nullptr;
+        batched = 0;
+        first = 0;
+        sending = 0;
+        attempts = 0;
+        inFlight = false;
+    }
+
+private:
+    const ACField* fields{ nullptr };
+    bool stamped{ true };
+    size_t fieldCount{ 0 };
+    size_t valueCount{ 0 };
+    size_t batchCap{ 1 };
+    double rate{ 1 };
+    std::vector<ACValue> values;       // batchCap snapshots of valueCount
+    std::vector<LapTimeText> times;    // per sample and field
+    std::vector<UA_WriteValue> writeValues;
+    UA_WriteRequest req;
+    ACSharedOutData scratch;
+    size_t batched{ 0 };   // samples filled into the batch
+    size_t first{ 0 };     // first one not yet acknowledged
+    size_t sending{ 0 };   // in the request in flight, from first on
+    size_t limit{ 1 };     // samples per request, halved on refusals
+    int attempts{ 0 };     // refusals in a row
+    bool inFlight{ false };
+    double tokens{ 0 };
+    std::chrono::steady_clock::time_point lastRefill;
+    bool hasRefill{ false };
+    uint64_t sentCount{ 0 };
+    uint64_t failedCount{ 0 };
+
+    static void onResponse(UA_Client*, void* userdata, UA_UInt32, UA_WriteResponse* resp) {
+        static_cast<BackfillWriter*>(userdata)->complete(*resp);
+    }
+
+    void complete(const UA_WriteResponse& resp) {
+        inFlight = false;
+        if (batched == 0) return; // cleared meanwhile
+        UA_StatusCode sc = resp.responseHeader.serviceResult;
+        if (sc == UA_STATUSCODE_GOOD && resp.resultsSize != sending * fieldCount) sc = UA_STATUSCODE_BADUNEXPECTEDERROR;
+        if (sc != UA_STATUSCODE_GOOD) {
+            if (linkLost(sc)) return; // sent again after the reconnect
+            std::cerr << "Backfill write of " << sending << " samples failed: status=0x" << std::hex
+                << (unsigned)sc << std::dec;
+            if (sc != UA_STATUSCODE_BADTIMEOUT && ++attempts < MaxAttempts) {
+                limit = std::max<size_t>(1, sending / 2);
+                std::cerr << ", retrying " << limit << " at a time\n";
+                return;
+            }
+            std::cerr << ", dropping " << batched - first << " samples\n";
+            ++failedCount;
+            attempts = 0;
+            first = batched = 0;
+            return;
+        }
+        size_t badItems = 0;
+        for (size_t i = 0; i < resp.resultsSize; ++i)
+            if (resp.results[i] != UA_STATUSCODE_GOOD) ++badItems;
+        if (badItems) std::cerr << "Backfill write: " << badItems << " of " << resp.resultsSize << " values refused\n";
+        attempts = 0;
+        sentCount += sending;
+        first += sending;
+        if (first == batched) first = batched = 0;
+    }
+
+    void fill(size_t s, const ACSharedOutData& snap) {
+        std::memcpy(&values[s * valueCount], snap.values, valueCount * sizeof(ACValue));
+        UA_DateTime ts = toUaDateTime(snap.sampledUtcNs);
+        for (size_t k = 0; k < fieldCount; ++k) {
+            writeValues[s * fieldCount + k].value.sourceTimestamp = ts;
+            if (fields[k].type != ACValueType::LapTime) continue;
+            LapTimeText& t = times[s * fieldCount + k];
+            t.str.length = formatLapTime(snap.values[fields[k].slot].i, t.chars, sizeof(t.chars));
+        }
+    }
+};
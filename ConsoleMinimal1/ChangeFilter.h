@@ -0,0 +1,128 @@
+#pragma once
+#include "ACSharedOut.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+enum class DeadbandKind : uint8_t { None, Absolute, Percent };
+
+// Report-by-exception: keeps the last value sent per field and selects only
+// the fields that moved past their deadband, or that have not been sent for
+// forceRefreshMs. Fields without a deadband go out on any change; array
+// fields go out whole when any element moved past the deadband.
+class ChangeFilter {
+public:
+    // spec is "name:amount[%],..." e.g. "engineRPM:50,steerAngle:1,fuel:2%".
+    // forceRefreshMs <= 0 disables the periodic refresh.
+    bool build(const ACField* table, size_t count, const std::string& spec, int forceRefreshMs) {
+        fields = table;
+        entries.assign(count, Entry());
+        last.assign(acValueCount(table, count), ACValue());
+        selected.assign(count, 0);
+        refreshMs = forceRefreshMs;
+
+        size_t pos = 0;
+        while (pos < spec.size()) {
+            size_t end = spec.find(',', pos);
+            if (end == std::string::npos) end = spec.size();
+            std::string item = spec.substr(pos, end - pos);
+            pos = end + 1;
+            if (item.empty()) continue;
+
+            size_t colon = item.find(':');
+            if (colon == std::string::npos) {
+                std::cerr << "Deadband '" << item << "' is not name:amount\n";
+                return false;
+            }
+            std::string name = item.substr(0, colon);
+            std::string amount = item.substr(colon + 1);
+            DeadbandKind kind = DeadbandKind::Absolute;
+            if (!amount.empty() && amount.back() == '%') { kind = DeadbandKind::Percent; amount.pop_back(); }
+
+            char* parsedEnd = nullptr;
+            float value = std::strtof(amount.c_str(), &parsedEnd);
+            if (amount.empty() || *parsedEnd != '\0' || value < 0) {
+                std::cerr << "Deadband '" << item << "' has an invalid amount\n";
+                return false;
+            }
+
+            bool known = false;
+            for (size_t k = 0; k < count; ++k) {
+                if (name != fields[k].name) continue;
+                entries[k].kind = kind;
+                entries[k].amount = value;
+                known = true;
+            }
+            if (!known) {
+                std::cerr << "Deadband for unknown field '" << name << "'\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Mask of fields to send for this snapshot (one byte per field)
+    const uint8_t* select(const ACSharedOutData& snap, int64_t nowMs, size_t& count) {
+        count = 0;
+        for (size_t k = 0; k < entries.size(); ++k) {
+            const Entry& e = entries[k];
+            bool due = !e.sent || (refreshMs > 0 && nowMs - e.lastMs >= refreshMs);
+            for (uint32_t v = fields[k].slot; !due && v < fields[k].slot + fields[k].count; ++v)
+                due = exceeds(e, value(k, last[v]), value(k, snap.values[v]));
+            selected[k] = due ? 1 : 0;
+            if (due) ++count;
+        }
+        suppressedTotal += entries.size() - count;
+        return selected.data();
+    }
+
+    // Record the selected values as sent; call only after a successful write
+    // so failed values are retried on the next cycle.
+    void commit(const ACSharedOutData& snap, int64_t nowMs) {
+        for (size_t k = 0; k < entries.size(); ++k) {
+            if (!selected[k]) continue;
+            for (uint32_t v = fields[k].slot; v < fields[k].slot + fields[k].count; ++v) last[v] = snap.values[v];
+            entries[k].lastMs = nowMs;
+            entries[k].sent = true;
+        }
+    }
+
+    // Forget what was sent, e.g. after a reconnect
+    void reset() {
+        for (auto& e : entries) e.sent = false;
+    }
+
+    uint64_t suppressed() const { return suppressedTotal; }
+
+private:
+    struct Entry {
+        DeadbandKind kind{ DeadbandKind::None };
+        float amount{ 0.0f };
+        bool sent{ false };
+        int64_t lastMs{ 0 };
+    };
+
+    const ACField* fields{ nullptr };
+    std::vector<Entry> entries;
+    std::vector<ACValue> last; // last sent, per snapshot value
+    std::vector<uint8_t> selected;
+    int refreshMs{ 0 };
+    uint64_t suppressedTotal{ 0 };
+
+    double value(size_t k, ACValue v) const {
+        return fields[k].type == ACValueType::Float ? static_cast<double>(v.f) : static_cast<double>(v.i);
+    }
+
+    static bool exceeds(const Entry& e, double last, double current) {
+        double diff = std::fabs(current - last);
+        switch (e.kind) {
+        case DeadbandKind::Absolute: return diff > e.amount;
+        case DeadbandKind::Percent: return diff > std::fabs(last) * e.amount / 100.0;
+        default: return diff != 0.0;
+        }
+    }
+};
@@ -3,15 +3,33 @@
 #include <open62541/client.h>
 #include <open62541/client_config_default.h>
 #include "ACSharedOut.h"
+#include "Aggregator.h"
+#include "AllocCounter.h"
+#include "EndpointPublisher.h"
+#include "FrameSampler.h"
+#include "LapAnalytics.h"
+#include "LatencyReporter.h"
+#include "PublishPlan.h"
+#include "Recorder.h"
+#include "RigMap.h"
+#include "SpscRing.h"
+#include "StatusRenderer.h"
+#include "TelemetryServer.h"
+#include "UadpPublisher.h"
 #include "dotenv.h"
 
+#include <atomic>
+#include <csignal>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <thread>
 #include <vector>
 #include <chrono>
+#include <cmath>
 #include <cstdlib>
 #include <string>
+#include <type_traits>
 
 
 // Portable safe getenv
@@ -33,6 +51,23 @@ static std::string safe_getenv(const char* name) {
 }
 #endif
 
+// Numeric setting: fallback when unset, false with a message naming the
+// variable when text is not a number in [min, max] (whole for integer T)
+template <typename T>
+static bool readSetting(const char* name, const std::string& text, T fallback, T min, T max, T& out) {
+    if (text.empty()) { out = fallback; return true; }
+    char* end = nullptr;
+    double v = std::strtod(text.c_str(), &end);
+    bool whole = std::is_floating_point<T>::value || v == std::floor(v);
+    if (*end != '\0' || !whole || !(v >= static_cast<double>(min) && v <= static_cast<double>(max))) {
+        std::cerr << "Invalid " << name << ": '" << text << "', expected " << (std::is_floating_point<T>::value ? "a number" : "a whole number")
+            << " from " << min << " to " << max << "\n";
+        return false;
+    }
+    out = static_cast<T>(v);
+    return true;
+}
+
 static UA_ByteString loadFile(const char* path) {
     std::ifstream f(path, std::ios::binary);
     if (!f) { std::cerr << "Cannot open file: " << path << "\n"; return UA_BYTESTRING_NULL; }
@@ -49,47 +84,10 @@ static UA_ByteString loadFile(const char* path) {
     return out;
 }
 
-static bool batchWriteValues(UA_Client* client,
-    const std::vector<std::string>& nodeIds,
-    const std::vector<UA_Variant>& variants) {
-    if (nodeIds.empty() || nodeIds.size() != variants.size()) return false;
-
-    std::vector<UA_NodeId> ids(nodeIds.size());
-    std::vector<UA_WriteValue> w(nodeIds.size());
-
-    for (size_t i = 0; i < nodeIds.size(); ++i) {
-        ids[i] = UA_NODEID_STRING_ALLOC(3, nodeIds[i].c_str());
-        UA_WriteValue_init(&w[i]);
-        w[i].nodeId = ids[i];
-        w[i].attributeId = UA_ATTRIBUTEID_VALUE;
-        w[i].value.hasValue = true;
-        w[i].value.value = variants[i];
-    }
-
-    UA_WriteRequest req; UA_WriteRequest_init(&req);
-    req.nodesToWrite = w.data();
-    req.nodesToWriteSize = w.size();
+// Ctrl+C ends the publish loop so everything shuts down and reports
+static volatile std::sig_atomic_t stopRequested = 0;
 
-    UA_WriteResponse resp = UA_Client_Service_write(client, req);
-    bool ok = (resp.responseHeader.serviceResult == UA_STATUSCODE_GOOD) && (resp.resultsSize == w.size());
-    if (ok) {
-        for (size_t i = 0; i < resp.resultsSize; ++i) {
-            if (resp.results[i] != UA_STATUSCODE_GOOD) {
-                std::cerr << "Batch write failed at " << i << " (ns=3;s:" << nodeIds[i]
-                    << ") status=0x" << std::hex << (unsigned)resp.results[i] << std::dec << "\n";
-                ok = false;
-            }
-        }
-    }
-    else {
-        std::cerr << "Batch write request failed: status=0x" << std::hex
-            << (unsigned)resp.responseHeader.serviceResult << std::dec << "\n";
-    }
-
-    UA_WriteResponse_clear(&resp);
-    for (auto& id : ids) UA_NodeId_clear(&id);
-    return ok;
-}
+static void onSignal(int) { stopRequested = 1; }
 
 int main() {
     // Load .env
@@ -100,163 +98,359 @@ int main() {
     std::string password = safe_getenv("PASSWORD");
     std::string delayStr = safe_getenv("DELAY_MS");
     std::string hostname = safe_getenv("HOSTNAME");
+    std::string consistentStr = safe_getenv("CONSISTENT_READS");
+    std::string resolveStr = safe_getenv("RESOLVE_NODEIDS");
+    std::string changeOnlyStr = safe_getenv("CHANGE_ONLY");
+    std::string deadbands = safe_getenv("DEADBANDS");
+    std::string refreshStr = safe_getenv("FORCE_REFRESH_MS");
+    std::string samplerStr = safe_getenv("SAMPLER");
+    std::string spinStr = safe_getenv("SPIN_US");
+    std::string queuePolicyStr = safe_getenv("QUEUE_POLICY");
+    std::string queueSizeStr = safe_getenv("QUEUE_SIZE");
+    std::string writeModeStr = safe_getenv("WRITE_MODE");
+    std::string windowStr = safe_getenv("WRITE_WINDOW");
+    std::string displayModeStr = safe_getenv("DISPLAY_MODE");
+    std::string displayMsStr = safe_getenv("DISPLAY_MS");
+    std::string tagMap = safe_getenv("TAG_MAP");
+    std::string recordDir = safe_getenv("RECORD_DIR");
+    std::string recordSegmentStr = safe_getenv("RECORD_SEGMENT_MB");
+    std::string latencyReportStr = safe_getenv("LATENCY_REPORT_S");
+    std::string latencyLog = safe_getenv("LATENCY_LOG");
+    std::string reconnectMinStr = safe_getenv("RECONNECT_MIN_MS");
+    std::string reconnectMaxStr = safe_getenv("RECONNECT_MAX_MS");
+    std::string storeSamplesStr = safe_getenv("STORE_SAMPLES");
+    std::string spillDir = safe_getenv("SPILL_DIR");
+    std::string spillMaxStr = safe_getenv("SPILL_MAX_MB");
+    std::string backfillBatchStr = safe_getenv("BACKFILL_BATCH");
+    std::string backfillRateStr = safe_getenv("BACKFILL_RATE");
+    std::string sourceTimestampsStr = safe_getenv("SOURCE_TIMESTAMPS");
+    std::string rigMapPath = safe_getenv("RIG_MAP");
+    std::string rigSessionsStr = safe_getenv("RIG_SESSIONS");
+    std::string analyticsWindowStr = safe_getenv("ANALYTICS_WINDOW_S");
+    std::string serverPortStr = safe_getenv("SERVER_PORT");
+    std::string pubsubUrl = safe_getenv("PUBSUB_URL");
+    std::string pubsubPublisherStr = safe_getenv("PUBSUB_PUBLISHER_ID");
+    std::string pubsubGroupStr = safe_getenv("PUBSUB_WRITER_GROUP");
     std::string uri = "urn:" + hostname + ":SimpleUAClient";
 
-    int DELAY = delayStr.empty() ? 100 : std::stoi(delayStr);
-
-    if (endpoint.empty() || username.empty() || password.empty()) {
-        std::cerr << "Missing .env file\n";
+    int DELAY = 0, forceRefreshMs = 0, spinUs = 0, queueSize = 0, writeWindow = 0, displayMs = 0, latencyReportSec = 0;
+    int reconnectMinMs = 0, reconnectMaxMs = 0, analyticsWindowSec = 0, serverPort = 0, pubsubPublisher = 0, pubsubGroup = 0;
+    size_t recordSegmentMb = 0, storeSamples = 0, spillMaxMb = 0, backfillBatch = 0, rigSessions = 0;
+    double backfillRate = 0;
+    if (!readSetting("DELAY_MS", delayStr, 100, 1, 60000, DELAY) ||
+        !readSetting("FORCE_REFRESH_MS", refreshStr, 0, 0, 3600000, forceRefreshMs) ||
+        !readSetting("SPIN_US", spinStr, 200, 0, 1000000, spinUs) ||
+        !readSetting("QUEUE_SIZE", queueSizeStr, 64, 1, 65536, queueSize) ||
+        !readSetting("WRITE_WINDOW", windowStr, 4, 1, 1024, writeWindow) ||
+        !readSetting("DISPLAY_MS", displayMsStr, 250, 10, 60000, displayMs) ||
+        !readSetting<size_t>("RECORD_SEGMENT_MB", recordSegmentStr, 64, 1, 4096, recordSegmentMb) ||
+        !readSetting("LATENCY_REPORT_S", latencyReportStr, 60, 0, 86400, latencyReportSec) ||
+        !readSetting("RECONNECT_MIN_MS", reconnectMinStr, 500, 1, 3600000, reconnectMinMs) ||
+        !readSetting("RECONNECT_MAX_MS", reconnectMaxStr, 30000, 1, 3600000, reconnectMaxMs) ||
+        !readSetting<size_t>("STORE_SAMPLES", storeSamplesStr, 1024, 1, 1000000, storeSamples) ||
+        !readSetting<size_t>("SPILL_MAX_MB", spillMaxStr, 256, 1, 1048576, spillMaxMb) ||
+        !readSetting<size_t>("BACKFILL_BATCH", backfillBatchStr, 25, 1, 10000, backfillBatch) ||
+        !readSetting("BACKFILL_RATE", backfillRateStr, 50.0, 0.1, 1000000.0, backfillRate) ||
+        !readSetting<size_t>("RIG_SESSIONS", rigSessionsStr, 1, 1, MaxPublishers, rigSessions) ||
+        !readSetting("ANALYTICS_WINDOW_S", analyticsWindowStr, 30, 1, 3600, analyticsWindowSec) ||
+        !readSetting("SERVER_PORT", serverPortStr, 0, 0, 65535, serverPort) ||
+        !readSetting("PUBSUB_PUBLISHER_ID", pubsubPublisherStr, 1, 0, 65535, pubsubPublisher) ||
+        !readSetting("PUBSUB_WRITER_GROUP", pubsubGroupStr, 1, 0, 65535, pubsubGroup))
         return 1;
-    }
-
-    ACSharedOut ac;
-    if (!ac.initialize()) {
-        std::cerr << "Failed to connect to Assetto Corsa shared memory.\n";
+    bool changeOnly = changeOnlyStr == "1";
+    SamplerMode samplerMode = samplerStr == "event" ? SamplerMode::Event : SamplerMode::Timer;
+    OverflowPolicy queuePolicy = queuePolicyStr == "drop-oldest" ? OverflowPolicy::DropOldest : OverflowPolicy::Coalesce;
+    bool asyncWrites = writeModeStr == "async";
+    bool headless = displayModeStr == "headless";
+    if (latencyLog.empty() && !headless) latencyLog = "latency.log"; // stderr would tear the status screen
+    bool sourceTimestamps = sourceTimestampsStr != "0";
+
+    // Writes to ENDPOINT, serves on SERVER_PORT, streams to PUBSUB_URL, or any mix
+    if (endpoint.empty() && serverPort == 0 && pubsubUrl.empty()) {
+        std::cerr << "Nothing to publish to: set ENDPOINT, SERVER_PORT or PUBSUB_URL (see .env.template)\n";
         return 1;
     }
-
-    // Certs (DER)
-    UA_ByteString clientCert = loadFile("certs/client_cert.der");
-    UA_ByteString clientKey = loadFile("certs/client_key.der");
-    UA_ByteString serverCert = loadFile("certs/server_cert.der");
-
-    if (clientCert.length == 0 || clientKey.length == 0) {
-        std::cerr << "Missing client_cert.der or client_key.der (DER encoded).\n";
+    if (!endpoint.empty() && (username.empty() || password.empty())) {
+        std::cerr << "ENDPOINT needs USERNAME and PASSWORD\n";
         return 1;
     }
 
-    UA_Client* client = UA_Client_new();
-    UA_ClientConfig* cc = UA_Client_getConfig(client);
-
-    cc->timeout = 30000;
-    cc->secureChannelLifeTime = 600000;
-    cc->requestedSessionTimeout = 600000.0;
-
-    cc->clientDescription.applicationUri = UA_STRING_ALLOC(uri.c_str());
-    cc->clientDescription.applicationType = UA_APPLICATIONTYPE_CLIENT;
-    cc->clientDescription.applicationName = UA_LOCALIZEDTEXT_ALLOC("en-US", "SimpleUAClient");
-    cc->clientDescription.productUri = UA_STRING_ALLOC("urn:SimpleUAClient");
-
-    std::vector<UA_ByteString> trustList;
-    if (serverCert.length > 0) trustList.push_back(serverCert);
+    // Rigs: the game's own pages, or every rig of RIG_MAP
+    std::vector<RigConfig> rigs;
+    RigMap rigMap;
+    if (rigMapPath.empty()) rigs.push_back(RigConfig{ "", "acpmf", {} });
+    else if (rigMap.load(rigMapPath)) rigs = rigMap.rigs();
+    else return 1;
+
+    // Tag mapping: compiled once, immutable from here on. Each rig gets its
+    // own copy of the tag map, laid out one after the other in the snapshot.
+    PublishPlan tags;
+    if (tagMap.empty()) tags.useDefaults();
+    else if (!tags.load(tagMap)) return 1;
+    PublishPlan plan;
+    for (const RigConfig& rig : rigs) {
+        std::string error;
+        if (!plan.addRig(tags, rig.objectIds, error)) {
+            std::cerr << "Cannot add rig " << (rig.name.empty() ? rig.mapping : rig.name) << " of " << rigs.size() << ": " << error << ".\n";
+            return 1;
+        }
+    }
 
-    UA_StatusCode sc = UA_ClientConfig_setDefaultEncryption(
-        cc, clientCert, clientKey,
-        trustList.empty() ? nullptr : trustList.data(), trustList.size(),
-        nullptr, 0);
+    std::vector<std::unique_ptr<ACSharedOut>> sources;
+    std::vector<ACSharedOut*> sourceList;
+    for (size_t r = 0; r < rigs.size(); ++r) {
+        sources.push_back(std::make_unique<ACSharedOut>());
+        ACSharedOut& ac = *sources.back();
+        if (!ac.initialize(rigs[r].mapping)) {
+            std::cerr << "Failed to connect to Assetto Corsa shared memory";
+            if (!rigs[r].name.empty()) std::cerr << " of rig " << rigs[r].name << " (" << rigs[r].mapping << ")";
+            std::cerr << ".\n";
+            return 1;
+        }
+        ac.setConsistentReads(consistentStr != "0");
+        if (!ac.setFields(plan.fields() + r * tags.size(), tags.size())) {
+            std::cerr << "Tag map does not fit the shared memory layout.\n";
+            return 1;
+        }
+        sourceList.push_back(&ac);
+    }
 
-    if (sc != UA_STATUSCODE_GOOD) {
-        std::cerr << "UA_ClientConfig_setDefaultEncryption failed: 0x"
-            << std::hex << sc << std::dec << "\n";
-        UA_Client_delete(client);
-        UA_ByteString_clear(&clientCert);
-        UA_ByteString_clear(&clientKey);
-        UA_ByteString_clear(&serverCert);
+    // Session recording runs on its own threads at the native physics rate
+    bool recording = !recordDir.empty();
+    if (recording && rigs.size() > 1) {
+        std::cerr << "RECORD_DIR records a single game, it cannot be combined with RIG_MAP.\n";
         return 1;
     }
+    Recorder recorder(*sources[0], recordDir, recordSegmentMb << 20, recording ? 1024 : 2);
+    if (recording && !recorder.start()) return 1;
+
+    // Endpoints: ENDPOINT plus ENDPOINT_2.. ENDPOINT_8. USERNAME_n/PASSWORD_n
+    // default to the first endpoint's credentials.
+    std::vector<EndpointConfig> endpoints;
+    if (!endpoint.empty()) endpoints.push_back(EndpointConfig{ endpoint, endpoint, username, password, UA_BYTESTRING_NULL });
+    for (size_t n = 2; n <= MaxEndpoints && !endpoints.empty(); ++n) {
+        std::string suffix = "_" + std::to_string(n);
+        std::string url = safe_getenv(("ENDPOINT" + suffix).c_str());
+        if (url.empty()) continue;
+        std::string user = safe_getenv(("USERNAME" + suffix).c_str());
+        std::string pass = safe_getenv(("PASSWORD" + suffix).c_str());
+        endpoints.push_back(EndpointConfig{ url, url, user.empty() ? username : user, pass.empty() ? password : pass,
+            UA_BYTESTRING_NULL });
+    }
 
-    cc->securityMode = UA_MESSAGESECURITYMODE_SIGNANDENCRYPT;
-    cc->securityPolicyUri =
-        UA_STRING_ALLOC("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+    // Certs (DER), only needed to write. Endpoint n may trust its own server_cert_<n>.der.
+    ClientIdentity identity{ uri, UA_BYTESTRING_NULL, UA_BYTESTRING_NULL };
+    if (!endpoints.empty()) {
+        identity.cert = loadFile("certs/client_cert.der");
+        identity.key = loadFile("certs/client_key.der");
+        if (identity.cert.length == 0 || identity.key.length == 0) {
+            std::cerr << "Missing client_cert.der or client_key.der (DER encoded).\n";
+            UA_ByteString_clear(&identity.cert);
+            UA_ByteString_clear(&identity.key);
+            return 1;
+        }
+        endpoints[0].serverCert = loadFile("certs/server_cert.der");
+    }
+    for (size_t i = 1; i < endpoints.size(); ++i) {
+        std::string path = "certs/server_cert_" + std::to_string(i + 1) + ".der";
+        if (std::ifstream(path)) endpoints[i].serverCert = loadFile(path.c_str());
+    }
 
-    sc = UA_Client_connectUsername(client,
-        endpoint.c_str(),
-        username.c_str(),
-        password.c_str());
-    if (sc != UA_STATUSCODE_GOOD) {
-        std::cerr << "Connect failed: 0x" << std::hex << sc << std::dec << "\n";
-        UA_Client_delete(client);
-        UA_ByteString_clear(&clientCert);
-        UA_ByteString_clear(&clientKey);
-        UA_ByteString_clear(&serverCert);
+    PublishOptions options;
+    options.queuePolicy = queuePolicy;
+    options.queueSize = static_cast<size_t>(queueSize);
+    options.changeOnly = changeOnly;
+    options.deadbands = deadbands;
+    options.forceRefreshMs = forceRefreshMs;
+    options.asyncWrites = asyncWrites;
+    options.writeWindow = static_cast<size_t>(writeWindow);
+    options.resolveNodeIds = resolveStr != "0";
+    options.sourceTimestamps = sourceTimestamps;
+    options.reconnectMinMs = reconnectMinMs;
+    options.reconnectMaxMs = reconnectMaxMs;
+    options.storeSamples = storeSamples;
+    options.spillDir = spillDir;
+    options.spillMaxBytes = spillMaxMb << 20;
+    options.backfillBatch = backfillBatch;
+    options.backfillRate = backfillRate;
+
+    // Session pool: every endpoint gets rigSessions clients, each writing a
+    // contiguous share of the rigs in combined requests
+    if (rigSessions < 1) rigSessions = 1;
+    if (rigSessions > rigs.size()) rigSessions = rigs.size();
+    if (endpoints.size() * rigSessions + (serverPort ? 1 : 0) + (pubsubUrl.empty() ? 0 : 1) > MaxPublishers) {
+        std::cerr << "Too many sessions: " << endpoints.size() << " endpoints x " << rigSessions
+            << " RIG_SESSIONS exceed " << MaxPublishers << ".\n";
         return 1;
     }
+    std::vector<PublishPlan> shares(rigSessions);
+    std::vector<std::string> shareNames(rigSessions);
+    for (size_t s = 0; s < rigSessions; ++s) {
+        size_t first = s * rigs.size() / rigSessions;
+        size_t last = (s + 1) * rigs.size() / rigSessions;
+        shares[s].slice(plan, first * tags.size(), (last - first) * tags.size());
+        if (rigSessions > 1) shareNames[s] = " [" + rigs[first].name + (last - first > 1 ? ".." + rigs[last - 1].name : "") + "]";
+    }
 
-    while (true) {
-        ACSharedOutData snap = ac.readGame();
-        if (!snap.ok) { std::cerr << "Read failed.\n"; break; }
-
-        system("cls");
-        std::cout << " #####################################\n";
-        std::cout << " # Assetto Corsa - XChange Interface #\n";
-        std::cout << " #####################################\n\n";
-        std::cout << "Connected. Writing every " << DELAY << " ms. Press Ctrl+C to stop.\n\n";
-
-        std::cout << "CAR DATA: " << DELAY << "ms update\n";
-        std::cout << "--------------------------\n";
-        std::cout << "Speed:        " << snap.vehicle["speedKmh"] << " km/h\n";
-        std::cout << "Engine RPM:   " << snap.vehicle["engineRPM"] << " RPM\n";
-        std::cout << "Steer Angle:  " << snap.vehicle["steerAngle"] << " degrees\n";
-        std::cout << "Gear:         " << snap.vehicle["gear"] << "\n";
-        std::cout << "Fuel:         " << snap.vehicle["fuel"] << " liters\n\n";
-
-        std::cout << "GAME INFO:\n";
-        std::cout << "--------------------------\n";
-        std::cout << "Completed Laps: " << snap.env["completedLaps"] << "\n";
-        std::cout << "Position:       " << snap.env["position"] << "\n";
-        std::cout << "Current Time:   " << snap.times["currentTime"] << "\n";
-        std::cout << "Last Time:      " << snap.times["lastTime"] << "\n";
-        std::cout << "Best Time:      " << snap.times["bestTime"] << "\n\n";
-        std::cout << "Press Ctrl+C to exit...";
-
-        // Prepare write variants
-        UA_Int32 speedVal = snap.vehicle["speedKmh"];
-        UA_Int32 rpmVal = snap.vehicle["engineRPM"];
-        UA_Int32 fuelVal = snap.vehicle["fuel"];
-        UA_Int32 steerVal = snap.vehicle["steerAngle"];
-        UA_Int32 gearVal = snap.vehicle["gear"];
-        UA_Int32 gasVal = snap.vehicle["gas"];
-        UA_Int32 brakeVal = snap.vehicle["brake"];
-        UA_Int32 numLapsVal = snap.env["numberOfLaps"];
-        UA_Int32 positionVal = snap.env["position"];
-        UA_Int32 completedLapsVal = snap.env["completedLaps"];
-        UA_String currentTimeVal = UA_STRING_ALLOC(snap.times["currentTime"].c_str());
-        UA_String lastTimeVal = UA_STRING_ALLOC(snap.times["lastTime"].c_str());
-        UA_String bestTimeVal = UA_STRING_ALLOC(snap.times["bestTime"].c_str());
-        UA_Float windSpeedVal = snap.miscFloats["windSpeed"];
-        UA_Float windDirectionVal = snap.miscFloats["windDirection"];
+    // One client, queue and thread per endpoint and session
+    std::vector<std::unique_ptr<EndpointPublisher>> publishers;
+    bool configured = true;
+    for (EndpointConfig e : endpoints) {
+        std::string url = e.name;
+        for (size_t s = 0; s < rigSessions; ++s) {
+            e.name = url + shareNames[s];
+            publishers.push_back(std::make_unique<EndpointPublisher>(e, shares[s], options));
+            if (!publishers.back()->configure(identity)) configured = false;
+        }
+    }
 
-        UA_Variant v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15;
-        UA_Variant_init(&v1);  UA_Variant_setScalar(&v1, &speedVal, &UA_TYPES[UA_TYPES_INT32]);
-        UA_Variant_init(&v2);  UA_Variant_setScalar(&v2, &rpmVal, &UA_TYPES[UA_TYPES_INT32]);
-        UA_Variant_init(&v3);  UA_Variant_setScalar(&v3, &fuelVal, &UA_TYPES[UA_TYPES_INT32]);
-        UA_Variant_init(&v4);  UA_Variant_setScalar(&v4, &steerVal, &UA_TYPES[UA_TYPES_INT32]);
-        UA_Variant_init(&v5);  UA_Variant_setScalar(&v5, &gearVal, &UA_TYPES[UA_TYPES_INT32]);
-        UA_Variant_init(&v6);  UA_Variant_setScalar(&v6, &gasVal, &UA_TYPES[UA_TYPES_INT32]);
-        UA_Variant_init(&v7);  UA_Variant_setScalar(&v7, &brakeVal, &UA_TYPES[UA_TYPES_INT32]);
-        UA_Variant_init(&v8);  UA_Variant_setScalar(&v8, &currentTimeVal, &UA_TYPES[UA_TYPES_STRING]);
-        UA_Variant_init(&v9);  UA_Variant_setScalar(&v9, &lastTimeVal, &UA_TYPES[UA_TYPES_STRING]);
-        UA_Variant_init(&v10); UA_Variant_setScalar(&v10, &bestTimeVal, &UA_TYPES[UA_TYPES_STRING]);
-        UA_Variant_init(&v11); UA_Variant_setScalar(&v11, &numLapsVal, &UA_TYPES[UA_TYPES_INT32]);
-        UA_Variant_init(&v12); UA_Variant_setScalar(&v12, &positionVal, &UA_TYPES[UA_TYPES_INT32]);
-        UA_Variant_init(&v13); UA_Variant_setScalar(&v13, &completedLapsVal, &UA_TYPES[UA_TYPES_INT32]);
-        UA_Variant_init(&v14); UA_Variant_setScalar(&v14, &windSpeedVal, &UA_TYPES[UA_TYPES_FLOAT]);
-        UA_Variant_init(&v15); UA_Variant_setScalar(&v15, &windDirectionVal, &UA_TYPES[UA_TYPES_FLOAT]);
+    // Embedded server: the whole plan as variables that clients subscribe to
+    std::unique_ptr<TelemetryServer> server;
+    if (serverPort) {
+        server = std::make_unique<TelemetryServer>(static_cast<uint16_t>(serverPort), uri + ":Telemetry", plan, DELAY, options);
+        if (!server->configure()) configured = false;
+    }
 
-        std::vector<std::string> nodeIds = {
-            "719:Car.speed","719:Car.rpm","719:Car.fuel","719:Car.steerAngle",
-            "719:Car.currentGear","719:Car.gas","719:Car.brake",
-            "723:GameEnviroment.currentTime","723:GameEnviroment.lastTime","723:GameEnviroment.bestTime",
-            "723:GameEnviroment.numberOfLaps","723:GameEnviroment.position","723:GameEnviroment.completedLaps",
-            "723:GameEnviroment.windSpeed","723:GameEnviroment.windDirection"
-        };
-        std::vector<UA_Variant> variants = { v1,v2,v3,v4,v5,v6,v7,v8,v9,v10,v11,v12,v13,v14,v15 };
+    // PubSub: every sample as UADP datagrams, one DataSetWriter per rig
+    std::unique_ptr<UadpPublisher> pubsub;
+    if (!pubsubUrl.empty()) {
+        pubsub = std::make_unique<UadpPublisher>(pubsubUrl, static_cast<uint16_t>(pubsubPublisher), static_cast<uint16_t>(pubsubGroup));
+        if (!pubsub->configure(plan, tags.size())) configured = false;
+    }
+    auto releaseCerts = [&] {
+        pubsub.reset();
+        server.reset();
+        publishers.clear();
+        for (EndpointConfig& e : endpoints) UA_ByteString_clear(&e.serverCert);
+        UA_ByteString_clear(&identity.cert);
+        UA_ByteString_clear(&identity.key);
+    };
+    if (!configured) {
+        releaseCerts();
+        return 1;
+    }
 
-        if (!batchWriteValues(client, nodeIds, variants))
-            std::cerr << "Batch write operation failed\n";
+    // Aggregate tags: every physics frame between two samples, on their own thread
+    Aggregator aggregator;
+    for (size_t r = 0; r < rigs.size(); ++r)
+        if (!aggregator.add(rigs[r].mapping, plan.fields() + r * tags.size(), tags.size(), consistentStr != "0")) {
+            releaseCerts();
+            return 1;
+        }
+    aggregator.start();
+
+    // Derived tags: lap and sector analytics, advanced once per sample
+    LapAnalytics analytics(static_cast<size_t>(analyticsWindowSec) * 1000 / (DELAY > 0 ? DELAY : 1));
+    for (size_t r = 0; r < rigs.size(); ++r) {
+        if (!analytics.add(rigs[r].mapping, plan.fields() + r * tags.size(), tags.size(), consistentStr != "0")) {
+            releaseCerts();
+            return 1;
+        }
+    }
 
-        UA_String_clear(&currentTimeVal);
-        UA_String_clear(&lastTimeVal);
-        UA_String_clear(&bestTimeVal);
+    // Sampler thread: shared memory -> every endpoint's ring (and the
+    // embedded server's), UADP datagrams sent right here. It never waits
+    // on the network, so neither a slow Galaxy round trip nor a dead endpoint
+    // can stall the sampling cadence or the other endpoints.
+    FrameSampler sampler(sourceList, samplerMode, DELAY, spinUs);
+    PublishLatency latency;
+    sampler.setHistograms(&latency.read, &latency.period, &latency.jitter);
+    SpscRing<ACSharedOutData> display(2); // latest sample for the status screen
+    std::atomic<bool> running{ true };
+    std::atomic<bool> readFailed{ false };
+    for (auto& p : publishers) p->start();
+    if (server) server->start();
+    std::thread samplerThread([&] {
+        ACSharedOutData frame;
+        while (running.load(std::memory_order_relaxed)) {
+            if (!sampler.next(frame)) continue; // no new frame
+            if (!frame.ok) { readFailed = true; break; }
+            if (!aggregator.empty()) aggregator.take(frame);
+            if (!analytics.empty()) analytics.update(frame);
+            if (pubsub) pubsub->publish(frame);
+            for (auto& p : publishers) p->offer(frame);
+            if (server) server->offer(frame);
+            display.push(frame);
+        }
+    });
+
+    LatencyReporter reporter(latencyReportSec, latencyLog);
+    reporter.add("sampler", latency);
+    for (auto& p : publishers) reporter.add(p->name(), p->latency());
+    if (server) reporter.add(server->name(), server->latency());
+    if (pubsub) reporter.add(pubsub->name(), pubsub->latency());
+    reporter.start();
+    std::signal(SIGINT, onSignal);
+    StatusRenderer renderer(displayMs, plan);
+    StatusFrame status;
+    status.delayMs = DELAY;
+    status.recording = recording;
+    status.rigCount = rigs.size();
+    status.shownRig = rigs[0].name;
+    status.endpointCount = publishers.size() + (server ? 1 : 0) + (pubsub ? 1 : 0);
+    if (!headless) renderer.start();
+
+    // Monitor: endpoint status and write rates, once every 50 ms. The
+    // embedded server and the PubSub publisher, if any, are the last rows.
+    std::vector<uint64_t> lastWritten(status.endpointCount, 0);
+    ACSharedOutData snap;
+    auto rateFrom = std::chrono::steady_clock::now();
+    while (!readFailed && !stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - rateFrom).count();
+        bool newRate = seconds >= 1.0;
+        for (size_t i = 0; i < status.endpointCount; ++i) {
+            double rate = status.endpoints[i].writeRate;
+            if (i < publishers.size()) status.endpoints[i] = publishers[i]->status();
+            else if (server && i == publishers.size()) status.endpoints[i] = server->status();
+            else status.endpoints[i] = pubsub->status();
+            status.endpoints[i].writeRate = rate;
+            if (newRate) {
+                status.endpoints[i].writeRate = (status.endpoints[i].written - lastWritten[i]) / seconds;
+                lastWritten[i] = status.endpoints[i].written;
+            }
+        }
+        if (newRate) rateFrom = now;
+        if (headless) continue;
 
-        UA_Client_run_iterate(client, 0);
-        std::this_thread::sleep_for(std::chrono::milliseconds(DELAY));
+        if (display.pop(snap, OverflowPolicy::Coalesce)) {
+            status.snap = snap;
+            status.hasSnap = true;
+        }
+        status.readRetries = 0;
+        status.tornReads = 0;
+        for (const auto& ac : sources) {
+            status.readRetries += ac->readStats().retries;
+            status.tornReads += ac->readStats().torn;
+        }
+        status.frames = sampler.stats().frames;
+        status.skipped = sampler.stats().skipped;
+        status.duplicates = sampler.stats().duplicates;
+        status.aggregated = aggregator.frames();
+        if (recording) {
+            status.recordFrames = recorder.stats().frames;
+            status.recordDropped = recorder.dropped() + recorder.stats().torn;
+            status.recordBytes = recorder.stats().bytes;
+            status.recordRawBytes = recorder.stats().rawBytes;
+            status.recordFailed = recorder.stats().failed;
+        }
+        renderer.update(status);
+    }
+    if (readFailed) std::cerr << "Read failed.\n";
+
+    running = false;
+    samplerThread.join();
+    aggregator.stop();
+    renderer.stop();
+    if (recording) {
+        recorder.stop();
+        if (recorder.stats().failed) std::cerr << "Recording stopped early, a segment could not be created.\n";
     }
+    for (auto& p : publishers) p->stop();
+    if (server) server->stop();
+    reporter.stop();
 
-    UA_Client_disconnect(client);
-    UA_Client_delete(client);
-    UA_ByteString_clear(&clientCert);
-    UA_ByteString_clear(&clientKey);
-    UA_ByteString_clear(&serverCert);
+    releaseCerts();
     return 0;
 }
@@ -0,0 +1,342 @@
+#pragma once
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include "ACSharedOut.h"
+#include "AllocCounter.h"
+#include "AsyncWriter.h"
+#include "BackfillWriter.h"
+#include "ChangeFilter.h"
+#include "LatencyReporter.h"
+#include "PreparedWrite.h"
+#include "PublishPlan.h"
+#include "Reconnector.h"
+#include "SampleStore.h"
+#include "SpscRing.h"
+#include "StatusRenderer.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Publish settings every endpoint shares
+struct PublishOptions {
+    OverflowPolicy queuePolicy{ OverflowPolicy::Coalesce };
+    size_t queueSize{ 64 };
+    bool changeOnly{ false };
+    std::string deadbands;
+    int forceRefreshMs{ 0 };
+    bool asyncWrites{ false };
+    size_t writeWindow{ 4 };
+    bool resolveNodeIds{ true };
+    bool sourceTimestamps{ true };
+    int reconnectMinMs{ 500 };
+    int reconnectMaxMs{ 30000 };
+    size_t storeSamples{ 1024 };
+    std::string spillDir;
+    size_t spillMaxBytes{ 256u << 20 };
+    size_t backfillBatch{ 25 };
+    double backfillRate{ 50 };
+};
+
+// This client's certificate and URI, the same towards every server
+struct ClientIdentity {
+    std::string applicationUri;
+    UA_ByteString cert;
+    UA_ByteString key;
+};
+
+// One server to publish to
+struct EndpointConfig {
+    std::string name; // for logs and the status screen
+    std::string url;
+    std::string username;
+    std::string password;
+    UA_ByteString serverCert; // trusted server certificate, may be empty; not owned
+};
+
+// One OPC UA server fed from the shared sampler: its own client, queue and
+// thread, so a slow or unreachable server only ever delays itself. The
+// sampler hands every sample to offer(), which never blocks; the thread
+// writes them out (change filter, sync or pipelined writes), reconnects on
+// its own and backfills what it stored while the server was away.
+class EndpointPublisher {
+public:
+    EndpointPublisher(const EndpointConfig& endpoint, const PublishPlan& publishPlan, const PublishOptions& publishOptions)
+        : config(endpoint), plan(publishPlan), options(publishOptions), client(UA_Client_new()),
+          ring(publishOptions.queueSize),
+          asyncWriter(publishOptions.writeWindow, publishPlan.size(), publishPlan.valueCount()),
+          reconnector(endpoint.name, client, endpoint.url, endpoint.username, endpoint.password,
+              publishOptions.reconnectMinMs, publishOptions.reconnectMaxMs),
+          store(publishPlan.valueCount(), publishOptions.storeSamples, publishOptions.spillDir, publishOptions.spillMaxBytes) {
+        shown.name = config.name;
+        shown.storing = !options.spillDir.empty();
+        shown.asyncWrites = options.asyncWrites;
+        asyncWriter.setAgeHistogram(&stages.age);
+        asyncWriter.setStore(&store);
+    }
+
+    ~EndpointPublisher() {
+        stop();
+        reconnector.stop();
+        writer.clear();
+        backfill.clear();
+        UA_Client_delete(client);
+    }
+
+    EndpointPublisher(const EndpointPublisher&) = delete;
+    EndpointPublisher& operator=(const EndpointPublisher&) = delete;
+
+    // Client security settings and prepared requests; nothing is connected yet
+    bool configure(const ClientIdentity& identity) {
+        UA_ClientConfig* cc = UA_Client_getConfig(client);
+        cc->timeout = 30000;
+        cc->secureChannelLifeTime = 600000;
+        cc->requestedSessionTimeout = 600000.0;
+        cc->clientContext = &sessionActivations;
+        cc->stateCallback = onClientState;
+
+        cc->clientDescription.applicationUri = UA_STRING_ALLOC(identity.applicationUri.c_str());
+        cc->clientDescription.applicationType = UA_APPLICATIONTYPE_CLIENT;
+        cc->clientDescription.applicationName = UA_LOCALIZEDTEXT_ALLOC("en-US", "SimpleUAClient");
+        cc->clientDescription.productUri = UA_STRING_ALLOC("urn:SimpleUAClient");
+
+        std::vector<UA_ByteString> trustList;
+        if (config.serverCert.length > 0) trustList.push_back(config.serverCert);
+        UA_StatusCode sc = UA_ClientConfig_setDefaultEncryption(
+            cc, identity.cert, identity.key,
+            trustList.empty() ? nullptr : trustList.data(), trustList.size(),
+            nullptr, 0);
+        if (sc != UA_STATUSCODE_GOOD) {
+            std::cerr << "[" << config.name << "] UA_ClientConfig_setDefaultEncryption failed: 0x"
+                << std::hex << sc << std::dec << "\n";
+            return false;
+        }
+        cc->securityMode = UA_MESSAGESECURITYMODE_SIGNANDENCRYPT;
+        cc->securityPolicyUri = UA_STRING_ALLOC("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+
+        // NodeIds and the WriteRequest are built once; each tick patches payloads
+        writer.setSourceTimestamps(options.sourceTimestamps);
+        backfill.setSourceTimestamps(options.sourceTimestamps);
+        if (!writer.build(plan.fields(), plan.size())) {
+            std::cerr << "[" << config.name << "] Failed to prepare write request\n";
+            return false;
+        }
+        if (!backfill.build(plan.fields(), plan.size(), options.backfillBatch, options.backfillRate) || !backfill.setNodeIds(writer)) {
+            std::cerr << "[" << config.name << "] Failed to prepare backfill request\n";
+            return false;
+        }
+        if (options.changeOnly && !filter.build(plan.fields(), plan.size(), options.deadbands, options.forceRefreshMs)) {
+            std::cerr << "[" << config.name << "] Invalid DEADBANDS setting.\n";
+            return false;
+        }
+        return true;
+    }
+
+    // Connects and publishes on the endpoint's own thread. A server that is
+    // not reachable yet is retried like a dropped connection.
+    void start() {
+        running = true;
+        worker = std::thread([this] { run(); });
+    }
+
+    // Stops publishing: pipelined writes get a moment to complete, samples
+    // still stored are reported and discarded
+    void stop() {
+        if (!worker.joinable()) return;
+        running = false;
+        worker.join();
+        reconnector.stop();
+        if (options.asyncWrites && reconnector.connected()) asyncWriter.drain(client, 2000);
+        if (reconnector.connected()) UA_Client_disconnect(client); // writes still in flight land in the store
+        if (!store.empty() || backfill.pending())
+            std::cerr << "[" << config.name << "] " << store.size() + backfill.pending() << " stored samples were not sent.\n";
+        store.clear();
+    }
+
+    // Sampler thread; never blocks, the queue policy decides what a slow
+    // endpoint loses
+    void offer(const ACSharedOutData& snap) { ring.push(snap); }
+
+    EndpointStatus status() const {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        return shown;
+    }
+
+    const PublishLatency& latency() const { return stages; }
+    const std::string& name() const { return config.name; }
+
+private:
+    EndpointConfig config;
+    const PublishPlan& plan;
+    PublishOptions options;
+    UA_Client* client;
+    std::atomic<unsigned> sessionActivations{ 0 };
+    SpscRing<ACSharedOutData> ring;
+    PreparedWrite writer;
+    ChangeFilter filter;
+    AsyncWriter asyncWriter;
+    Reconnector reconnector;
+    SampleStore store;
+    BackfillWriter backfill;
+    PublishLatency stages;
+    std::atomic<bool> running{ false };
+    std::thread worker;
+
+    // Publish thread only, copied to shown for the status screen
+    uint64_t cycleAllocs{ 0 };
+    int64_t frameAgeUs{ 0 };
+    uint64_t written{ 0 };
+    mutable std::mutex statusMutex;
+    EndpointStatus shown;
+
+    // Counts session activations so NodeIds are re-resolved after a reconnect
+    static void onClientState(UA_Client* c, UA_SecureChannelState, UA_SessionState session, UA_StatusCode) {
+        if (session != UA_SESSIONSTATE_ACTIVATED) return;
+        std::atomic<unsigned>* activations = static_cast<std::atomic<unsigned>*>(UA_Client_getContext(c));
+        if (activations) ++*activations;
+    }
+
+    void publishStatus() {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        shown.connected = !reconnector.reconnecting() && reconnector.connected();
+        shown.reconnectAttempts = reconnector.attempts();
+        shown.reconnects = reconnector.reconnects();
+        shown.cycleAllocs = cycleAllocs;
+        shown.valuesSent = writer.selected();
+        shown.valueCount = writer.size();
+        shown.suppressed = filter.suppressed();
+        shown.written = options.asyncWrites ? asyncWriter.stats().acked : written;
+        shown.frameAgeUs = frameAgeUs;
+        shown.queued = ring.size();
+        shown.dropped = ring.dropped();
+        shown.coalesced = ring.coalesced();
+        shown.inFlight = asyncWriter.inFlight();
+        shown.failedRequests = asyncWriter.stats().failedRequests;
+        shown.failedItems = asyncWriter.stats().failedItems;
+        shown.stored = store.size() + backfill.pending();
+        shown.spillBytes = store.spillBytes();
+        shown.storeDropped = store.dropped();
+        shown.backfilled = backfill.sent();
+    }
+
+    void lost() {
+        std::cerr << "[" << config.name << "] Connection lost, reconnecting\n";
+        reconnector.start();
+    }
+
+    void run() {
+        UA_StatusCode sc = UA_Client_connectUsername(client, config.url.c_str(), config.username.c_str(), config.password.c_str());
+        if (sc != UA_STATUSCODE_GOOD) {
+            std::cerr << "[" << config.name << "] Connect failed: 0x" << std::hex << sc << std::dec << ", retrying\n";
+            reconnector.start();
+        }
+        unsigned seenSession = 0;
+        ACSharedOutData snap; // reused, a snapshot is large to construct
+
+        // Publisher: ring -> OPC UA
+        while (running.load(std::memory_order_relaxed)) {
+            // Outage: park every sample until the reconnect thread is done
+            if (reconnector.reconnecting()) {
+                while (ring.pop(snap, OverflowPolicy::DropOldest)) store.push(snap);
+                if (!reconnector.poll()) {
+                    publishStatus();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                std::cerr << "[" << config.name << "] Connected after " << reconnector.lastOutageMs() << " ms, "
+                    << store.size() + backfill.pending() << " samples to backfill\n";
+            }
+
+            if (seenSession != sessionActivations) {
+                if (options.resolveNodeIds) {
+                    size_t n = 0;
+                    UA_StatusCode sc = writer.resolveNodeIds(client, n);
+                    if (sc != UA_STATUSCODE_GOOD)
+                        std::cerr << "[" << config.name << "] RegisterNodes failed: 0x" << std::hex << sc << std::dec
+                            << ", writing the configured node ids\n";
+                    else if (n == 0)
+                        std::cerr << "[" << config.name << "] Server returned the configured node ids, writing string ids\n";
+                    else
+                        std::cerr << "[" << config.name << "] Registered " << n << " of " << writer.size()
+                            << " node ids as server handles\n";
+                    backfill.setNodeIds(writer);
+                }
+                filter.reset(); // new session: send everything once
+                seenSession = sessionActivations;
+            }
+
+            // Window full: leave samples queued and let responses come in
+            if (options.asyncWrites && asyncWriter.full()) {
+                if (reconnector.connected()) UA_Client_run_iterate(client, 1);
+                else lost();
+                continue;
+            }
+
+            uint64_t allocsBefore = heapAllocations();
+            if (!ring.pop(snap, options.queuePolicy)) { // nothing live queued: time for backfill
+                if (!store.empty() || backfill.pending()) backfill.step(client, store);
+                if (reconnector.connected()) UA_Client_run_iterate(client, 1);
+                else lost();
+                continue;
+            }
+
+            auto popped = std::chrono::steady_clock::now();
+            int64_t poppedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(popped.time_since_epoch()).count();
+            stages.queue.record(poppedNs - snap.sampledNs);
+
+            writer.update(snap);
+            int64_t nowMs = poppedNs / 1000000;
+            if (options.changeOnly) {
+                size_t changed = 0;
+                writer.select(filter.select(snap, nowMs, changed));
+            }
+            auto built = std::chrono::steady_clock::now();
+            stages.build.record(built - popped);
+
+            if (options.asyncWrites) {
+                // Committed when sent; a failed response resets the filter below.
+                // A sample that cannot be sent, or dies in flight with the
+                // connection, goes to the store like a sync one.
+                if (asyncWriter.send(client, writer, snap) && options.changeOnly)
+                    filter.commit(snap, nowMs);
+            }
+            else {
+                if (writer.send(client)) {
+                    ++written;
+                    if (options.changeOnly) filter.commit(snap, nowMs);
+                }
+                else if (!reconnector.connected()) { // keep the sample for backfill
+                    store.push(snap);
+                    lost();
+                    continue;
+                }
+                else {
+                    std::cerr << "[" << config.name << "] Batch write operation failed\n";
+                }
+            }
+            auto sent = std::chrono::steady_clock::now();
+            stages.write.record(sent - built);
+            if (!options.asyncWrites) {
+                int64_t ageNs = std::chrono::duration_cast<std::chrono::nanoseconds>(sent.time_since_epoch()).count() - snap.sampledNs;
+                stages.age.record(ageNs);
+                frameAgeUs = ageNs / 1000;
+            }
+
+            UA_Client_run_iterate(client, 0);
+            stages.iterate.record(std::chrono::steady_clock::now() - sent);
+            if (options.asyncWrites) {
+                if (asyncWriter.takeFailures() > 0) filter.reset();
+                frameAgeUs = asyncWriter.stats().lastAgeUs;
+            }
+            cycleAllocs = heapAllocations() - allocsBefore;
+            stages.cycle.record(std::chrono::steady_clock::now() - popped);
+            if (!reconnector.connected()) lost();
+
+            publishStatus();
+        }
+    }
+};
@@ -0,0 +1,153 @@
+#pragma once
+#include "ACSharedOut.h"
+#include "LatencyHistogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// Timer: sample every period, whatever frame is in the page.
+// Event: after the period, wait for AC to produce a new physics frame and
+// sample it right away, so frame age at publish starts near zero.
+enum class SamplerMode { Timer, Event };
+
+// (atomic: the sampler may run on its own thread; summed over all sources)
+struct SamplerStats {
+    std::atomic<uint64_t> frames{ 0 };     // distinct physics frames sampled
+    std::atomic<uint64_t> skipped{ 0 };    // frames AC produced that were never sampled
+    std::atomic<uint64_t> duplicates{ 0 }; // samples that repeated the previous frame
+    std::atomic<uint64_t> idle{ 0 };       // event waits that timed out (paused, menus)
+};
+
+class FrameSampler {
+public:
+    FrameSampler(ACSharedOut& source, SamplerMode samplerMode, int periodMs, int spinUs = 200, int idleTimeoutMs = 1000)
+        : FrameSampler(std::vector<ACSharedOut*>{ &source }, samplerMode, periodMs, spinUs, idleTimeoutMs) {}
+
+    // Several rigs into one snapshot, read one after the other (their field
+    // tables must not overlap, see ACSharedOut::readInto()). Event mode
+    // waits for the first source; packetIds in the snapshot are its too.
+    FrameSampler(const std::vector<ACSharedOut*>& sourceList, SamplerMode samplerMode, int periodMs, int spinUs = 200,
+                 int idleTimeoutMs = 1000)
+        : sources(sourceList), mode(samplerMode), period(periodMs), spin(spinUs), idleTimeout(idleTimeoutMs),
+          lastPacketIds(sourceList.size(), 0), hasLast(sourceList.size(), false) {
+#ifdef _WIN32
+        timeBeginPeriod(1); // 1 ms sleep granularity for the poll loop
+#endif
+    }
+
+    ~FrameSampler() {
+#ifdef _WIN32
+        timeEndPeriod(1);
+#endif
+    }
+
+    // Next sample into out. Returns false when event mode saw no new frame
+    // within idleTimeoutMs; out is left untouched then.
+    bool next(ACSharedOutData& out) {
+        if (started) std::this_thread::sleep_for(period);
+        started = true;
+
+        if (mode == SamplerMode::Event && hasLast[0] && !waitForFrame()) {
+            ++samplerStats.idle;
+            return false;
+        }
+
+        auto readStart = std::chrono::steady_clock::now();
+        read(out);
+        if (readTimes) {
+            auto readEnd = std::chrono::steady_clock::now();
+            readTimes->record(readEnd - readStart);
+            if (hasSample) {
+                auto gap = readStart - lastSample;
+                periods->record(gap);
+                jitters->record(gap > period ? gap - period : period - gap);
+            }
+            lastSample = readStart;
+            hasSample = true;
+        }
+        return true;
+    }
+
+    // Optional timings, recorded on the sampling thread
+    void setHistograms(LatencyHistogram* read, LatencyHistogram* samplePeriod, LatencyHistogram* jitter) {
+        readTimes = read;
+        periods = samplePeriod;
+        jitters = jitter;
+    }
+
+    const SamplerStats& stats() const { return samplerStats; }
+
+private:
+    std::vector<ACSharedOut*> sources;
+    SamplerMode mode;
+    std::chrono::milliseconds period;
+    std::chrono::microseconds spin;
+    std::chrono::milliseconds idleTimeout;
+    SamplerStats samplerStats;
+    bool started{ false };
+    std::vector<int> lastPacketIds; // per source
+    std::vector<bool> hasLast;
+    LatencyHistogram* readTimes{ nullptr };
+    LatencyHistogram* periods{ nullptr };
+    LatencyHistogram* jitters{ nullptr };
+    std::chrono::steady_clock::time_point lastSample;
+    bool hasSample{ false };
+
+    // Spin on packetId for a short while (frames are ~3 ms apart at full
+    // physics rate), then back off to short sleeps.
+    bool waitForFrame() {
+        auto start = std::chrono::steady_clock::now();
+        while (sources[0]->physicsPacketId() == lastPacketIds[0]) {
+            auto waited = std::chrono::steady_clock::now() - start;
+            if (waited >= idleTimeout) return false;
+            if (waited < spin) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        return true;
+    }
+
+    void read(ACSharedOutData& out) {
+        if (sources.size() == 1) {
+            if (sources[0]->readInto(out)) account(0, out.physicsPacketId);
+            return;
+        }
+        bool consistent = true;
+        int physicsPacketId = 0;
+        int graphicsPacketId = 0;
+        for (size_t s = 0; s < sources.size(); ++s) {
+            if (!sources[s]->readInto(out)) return; // ok stays false
+            consistent = consistent && out.consistent;
+            account(s, out.physicsPacketId);
+            if (s == 0) {
+                physicsPacketId = out.physicsPacketId;
+                graphicsPacketId = out.graphicsPacketId;
+            }
+        }
+        out.consistent = consistent;
+        out.physicsPacketId = physicsPacketId;
+        out.graphicsPacketId = graphicsPacketId;
+    }
+
+    void account(size_t source, int packetId) {
+        int& lastPacketId = lastPacketIds[source];
+        if (hasLast[source] && packetId == lastPacketId) {
+            ++samplerStats.duplicates;
+            return;
+        }
+        // packetId restarts with a new session; only count forward gaps
+        if (hasLast[source] && packetId > lastPacketId)
+            samplerStats.skipped += static_cast<uint64_t>(packetId - lastPacketId - 1);
+        ++samplerStats.frames;
+        lastPacketId = packetId;
+        hasLast[source] = true;
+    }
+};
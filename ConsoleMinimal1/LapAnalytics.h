@@ -0,0 +1,236 @@
+#pragma once
+#include "ACSharedOut.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Fills the derived.* tags of a plan from a few lap-timing fields of each
+// rig, so Galaxy gets fuel per lap, the live delta to the best lap, sector
+// splits and rolling tyre temperatures without scripting them. update()
+// runs once per sample on the sampler thread and does constant work per
+// sample: the lap trace only fills the position buckets passed since the
+// previous sample, a new best lap swaps traces instead of copying, and the
+// rolling average keeps a running sum over a ring of samples.
+class LapAnalytics {
+public:
+    // windowSamples: samples in the tyre temperature average
+    explicit LapAnalytics(size_t windowSamples) : window(windowSamples ? windowSamples : 1) {}
+
+    // Derived tags of table (one rig's share of the plan, inputs read from
+    // the pages at mapping). Other tags are ignored.
+    bool add(const std::string& mapping, const ACField* table, size_t count, bool consistentReads) {
+        std::unique_ptr<Rig> rig(new Rig());
+        for (size_t k = 0; k < count; ++k)
+            if (table[k].page == ACPage::Derived) rig->outputs.push_back(&table[k]);
+        if (rig->outputs.empty()) return true;
+
+        if (!rig->ac.initialize(mapping)) {
+            std::cerr << "Lap analytics cannot open shared memory " << mapping << "\n";
+            return false;
+        }
+        rig->ac.setConsistentReads(consistentReads);
+        if (!rig->ac.setFields(inputFields(), InputCount)) return false;
+        rig->lapTrace.assign(Buckets, 0.0f);
+        rig->bestTrace.assign(Buckets, 0.0f);
+        rig->tyreRing.assign(window * 4, 0.0f);
+        rigs.push_back(std::move(rig));
+        return true;
+    }
+
+    bool empty() const { return rigs.empty(); }
+
+    // Sampler thread: advances every rig by one sample and writes the
+    // derived tags into snap
+    void update(ACSharedOutData& snap) {
+        for (auto& r : rigs) {
+            Rig& rig = *r;
+            if (rig.ac.readInto(rig.in)) step(rig);
+            const unsigned char* page = reinterpret_cast<const unsigned char*>(&rig.page);
+            for (const ACField* f : rig.outputs) {
+                for (uint32_t e = 0; e < f->count; ++e) {
+                    double src;
+                    if (f->source == ACSourceType::Int32) { int32_t v; std::memcpy(&v, page + f->offset + e * 4, 4); src = v; }
+                    else { float v; std::memcpy(&v, page + f->offset + e * 4, 4); src = v; }
+                    double scaled = src * f->scale + f->bias;
+                    if (f->type == ACValueType::Float) snap.values[f->slot + e].f = static_cast<float>(scaled);
+                    else snap.values[f->slot + e].i = static_cast<int32_t>(scaled);
+                }
+            }
+        }
+    }
+
+private:
+    static const int Buckets = 1000;      // lap trace resolution, track position / 1000
+    static const int StartSlack = 20;     // a lap trace must start and end within 2% of the line
+
+    enum Input { Laps, Sector, LastSector, Position, CurrentTime, LastTime, Fuel, TyreTemp, InputCount = TyreTemp + 1 };
+
+    // Inputs, read as published values so the snapshot holds them converted
+    static const ACField* inputFields() {
+        static const ACField fields[InputCount] = {
+            { "completedLaps", "", ACPage::Graphics, offsetof(SPageFileGraphics, completedLaps), ACSourceType::Int32, ACValueType::Int32, 1.0f, 0.0f, 1, Laps },
+            { "currentSectorIndex", "", ACPage::Graphics, offsetof(SPageFileGraphics, currentSectorIndex), ACSourceType::Int32, ACValueType::Int32, 1.0f, 0.0f, 1, Sector },
+            { "lastSectorTime", "", ACPage::Graphics, offsetof(SPageFileGraphics, lastSectorTime), ACSourceType::Int32, ACValueType::Int32, 1.0f, 0.0f, 1, LastSector },
+            { "normalizedCarPosition", "", ACPage::Graphics, offsetof(SPageFileGraphics, normalizedCarPosition), ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 1, Position },
+            { "iCurrentTime", "", ACPage::Graphics, offsetof(SPageFileGraphics, iCurrentTime), ACSourceType::Int32, ACValueType::Int32, 1.0f, 0.0f, 1, CurrentTime },
+            { "iLastTime", "", ACPage::Graphics, offsetof(SPageFileGraphics, iLastTime), ACSourceType::Int32, ACValueType::Int32, 1.0f, 0.0f, 1, LastTime },
+            { "fuel", "", ACPage::Physics, offsetof(SPageFilePhysics, fuel), ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 1, Fuel },
+            { "tyreCoreTemperature", "", ACPage::Physics, offsetof(SPageFilePhysics, tyreCoreTemperature), ACSourceType::Float, ACValueType::Float, 1.0f, 0.0f, 4, TyreTemp },
+        };
+        return fields;
+    }
+
+    struct Rig {
+        ACSharedOut ac;
+        ACSharedOutData in;
+        std::vector<const ACField*> outputs;
+        ACDerivedPage page{};
+        bool started{ false };
+        int laps{ 0 };
+        int sector{ 0 };
+        float lapStartFuel{ 0 };
+        bool lapStartSeen{ false }; // false for the lap the bridge joined midway
+        double fuelSum{ 0 };
+        int fuelLaps{ 0 };
+        std::vector<float> lapTrace;  // ms at each position bucket of this lap
+        std::vector<float> bestTrace; // the same for the best lap
+        int filled{ -1 };             // last bucket of lapTrace set
+        bool traceValid{ false };
+        bool awaitingWrap{ false };   // new lap counted before the position wrapped to 0
+        float prevPos{ 0 };
+        float prevTime{ 0 };
+        int bestLapMs{ 0 };
+        std::vector<float> tyreRing;  // window x 4 wheels
+        double tyreSum[4]{};
+        size_t tyreNext{ 0 };
+        size_t tyreCount{ 0 };
+    };
+
+    size_t window;
+    std::vector<std::unique_ptr<Rig>> rigs;
+
+    void step(Rig& rig) {
+        const ACSharedOutData& in = rig.in;
+        int laps = in.i(Laps);
+        if (!rig.started || laps < rig.laps) restart(rig); // first sample or a new session
+        else if (laps > rig.laps) completeLap(rig);
+        sectors(rig);
+        trace(rig);
+        tyres(rig);
+        rig.page.fuelLapsLeft = rig.page.fuelPerLap > 0 ? in.f(Fuel) / rig.page.fuelPerLap : 0.0f;
+    }
+
+    void restart(Rig& rig) {
+        const ACSharedOutData& in = rig.in;
+        rig.page = ACDerivedPage{};
+        rig.started = true;
+        rig.laps = in.i(Laps);
+        rig.sector = in.i(Sector);
+        rig.lapStartFuel = in.f(Fuel);
+        rig.lapStartSeen = false;
+        rig.fuelSum = 0;
+        rig.fuelLaps = 0;
+        rig.filled = -1;
+        rig.traceValid = false;
+        rig.bestLapMs = 0;
+    }
+
+    void completeLap(Rig& rig) {
+        const ACSharedOutData& in = rig.in;
+        int laps = in.i(Laps);
+        float fuel = in.f(Fuel);
+        if (rig.lapStartSeen && laps == rig.laps + 1) {
+            float used = rig.lapStartFuel - fuel;
+            if (used > 0) { // not across a refuel
+                rig.page.fuelLastLap = used;
+                rig.fuelSum += used;
+                ++rig.fuelLaps;
+                rig.page.fuelPerLap = static_cast<float>(rig.fuelSum / rig.fuelLaps);
+            }
+            int lapMs = in.i(LastTime);
+            if (rig.traceValid && rig.filled >= Buckets - 1 - StartSlack && lapMs > 0 &&
+                (rig.bestLapMs == 0 || lapMs < rig.bestLapMs)) {
+                for (int b = rig.filled + 1; b < Buckets; ++b) rig.lapTrace[b] = static_cast<float>(lapMs);
+                rig.lapTrace.swap(rig.bestTrace);
+                rig.bestLapMs = lapMs;
+            }
+        }
+        rig.laps = laps;
+        rig.lapStartFuel = fuel;
+        rig.lapStartSeen = true;
+        rig.filled = -1;
+        rig.traceValid = true;
+        rig.awaitingWrap = in.f(Position) > 0.5f;
+    }
+
+    // lastSectorTime belongs to the sector just left
+    static void sectors(Rig& rig) {
+        int sector = rig.in.i(Sector);
+        if (sector == rig.sector) return;
+        int done = rig.sector;
+        int ms = rig.in.i(LastSector);
+        ACDerivedPage& p = rig.page;
+        if (done >= 0 && done < static_cast<int>(acMaxSectors) && ms > 0) {
+            p.sectorTimes[done] = ms;
+            if (p.bestSectorTimes[done] == 0 || ms < p.bestSectorTimes[done]) p.bestSectorTimes[done] = ms;
+        }
+        if (sector == 0 && done > 0) { // across the line
+            std::memcpy(p.lastLapSectorTimes, p.sectorTimes, sizeof(p.sectorTimes));
+            std::memset(p.sectorTimes, 0, sizeof(p.sectorTimes));
+        }
+        rig.sector = sector;
+    }
+
+    // Time at every position bucket passed since the previous sample,
+    // interpolated between the two samples; then the delta to the best lap
+    static void trace(Rig& rig) {
+        float pos = rig.in.f(Position);
+        float now = static_cast<float>(rig.in.i(CurrentTime));
+        rig.page.deltaToBest = 0;
+        if (!rig.traceValid) return;
+        if (rig.awaitingWrap) {
+            if (pos >= 0.5f) return;
+            rig.awaitingWrap = false;
+        }
+        int b = std::min(Buckets - 1, std::max(0, static_cast<int>(pos * Buckets)));
+        if (rig.filled < 0) { // first sample of the lap, which started at the line at 0 ms
+            if (b > StartSlack) { rig.traceValid = false; return; }
+            rig.prevPos = 0;
+            rig.prevTime = 0;
+        }
+        if (b > rig.filled && pos > rig.prevPos) {
+            for (int k = rig.filled + 1; k <= b; ++k) {
+                float at = static_cast<float>(k) / Buckets;
+                rig.lapTrace[k] = rig.prevTime + (now - rig.prevTime) * (at - rig.prevPos) / (pos - rig.prevPos);
+            }
+            rig.filled = b;
+        }
+        rig.prevPos = pos;
+        rig.prevTime = now;
+
+        if (rig.bestLapMs == 0 || b < rig.filled) return;
+        float x = pos * Buckets - b;
+        float from = rig.bestTrace[b];
+        float to = b + 1 < Buckets ? rig.bestTrace[b + 1] : static_cast<float>(rig.bestLapMs);
+        rig.page.deltaToBest = (now - (from + (to - from) * x)) / 1000.0f;
+    }
+
+    void tyres(Rig& rig) {
+        float* slot = &rig.tyreRing[rig.tyreNext * 4];
+        for (int w = 0; w < 4; ++w) {
+            float t = rig.in.f(TyreTemp + w);
+            if (rig.tyreCount == window) rig.tyreSum[w] -= slot[w];
+            slot[w] = t;
+            rig.tyreSum[w] += t;
+        }
+        rig.tyreNext = (rig.tyreNext + 1) % window;
+        if (rig.tyreCount < window) ++rig.tyreCount;
+        for (int w = 0; w < 4; ++w) rig.page.tyreTempAvg[w] = static_cast<float>(rig.tyreSum[w] / rig.tyreCount);
+    }
+};
@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Log-linear latency histogram in the style of HdrHistogram: every power of
+// two of nanoseconds is split into 32 linear buckets, so any recorded value
+// is kept to within ~3% up to ~68 s (larger values land in the top bucket).
+// record() is a bucket lookup and a couple of relaxed stores: one thread
+// records, any thread may take snapshots.
+class LatencyHistogram {
+public:
+    static const int SubBits = 5;
+    static const int MaxBits = 36;
+    static const size_t BucketCount = static_cast<size_t>(MaxBits - SubBits + 1) << SubBits;
+
+    // Bucket counts as of one moment; subtract two to get an interval
+    struct Snapshot {
+        std::vector<uint64_t> counts;
+        uint64_t total{ 0 };
+        int64_t sumNs{ 0 };
+
+        Snapshot() : counts(BucketCount, 0) {}
+
+        Snapshot operator-(const Snapshot& earlier) const {
+            Snapshot d;
+            for (size_t b = 0; b < BucketCount; ++b) d.counts[b] = counts[b] - earlier.counts[b];
+            d.total = total - earlier.total;
+            d.sumNs = sumNs - earlier.sumNs;
+            return d;
+        }
+
+        // Highest value of the bucket holding quantile q (0..1)
+        int64_t percentileNs(double q) const {
+            if (total == 0) return 0;
+            uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t b = 0; b < BucketCount; ++b) {
+                seen += counts[b];
+                if (seen >= rank) return bucketHigh(b);
+            }
+            return bucketHigh(BucketCount - 1);
+        }
+
+        int64_t maxNs() const {
+            for (size_t b = BucketCount; b-- > 0;)
+                if (counts[b]) return bucketHigh(b);
+            return 0;
+        }
+
+        int64_t meanNs() const { return total ? sumNs / static_cast<int64_t>(total) : 0; }
+    };
+
+    LatencyHistogram() : counts(new std::atomic<uint64_t>[BucketCount]) {
+        for (size_t b = 0; b < BucketCount; ++b) counts[b].store(0, std::memory_order_relaxed);
+    }
+    ~LatencyHistogram() { delete[] counts; }
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // Single writer: plain load/store instead of a locked add
+    void record(int64_t ns) {
+        std::atomic<uint64_t>& c = counts[bucketOf(ns < 0 ? 0 : static_cast<uint64_t>(ns))];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sumNs.store(sumNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    }
+
+    void record(std::chrono::steady_clock::duration d) {
+        record(static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+    }
+
+    // Taken while records continue, so sumNs may be a record or two ahead
+    Snapshot snapshot() const {
+        Snapshot s;
+        for (size_t b = 0; b < BucketCount; ++b) {
+            s.counts[b] = counts[b].load(std::memory_order_relaxed);
+            s.total += s.counts[b];
+        }
+        s.sumNs = sumNs.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    std::atomic<uint64_t>* counts;
+    std::atomic<int64_t> sumNs{ 0 };
+
+    static int highBit(uint64_t v) {
+#if defined(_MSC_VER) && defined(_WIN64)
+        unsigned long index;
+        _BitScanReverse64(&index, v);
+        return static_cast<int>(index);
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanReverse(&index, static_cast<unsigned long>(v >> 32))) return static_cast<int>(index) + 32;
+        _BitScanReverse(&index, static_cast<unsigned long>(v));
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(v);
+#endif
+    }
+
+    static size_t bucketOf(uint64_t v) {
+        if (v < (1u << SubBits)) return static_cast<size_t>(v);
+        int shift = highBit(v) - SubBits;
+        size_t b = (static_cast<size_t>(shift + 1) << SubBits) | static_cast<size_t>((v >> shift) & ((1u << SubBits) - 1));
+        return b < BucketCount ? b : BucketCount - 1;
+    }
+
+    static int64_t bucketHigh(size_t b) {
+        if (b < (1u << SubBits)) return static_cast<int64_t>(b);
+        int shift = static_cast<int>(b >> SubBits) - 1;
+        uint64_t low = (static_cast<uint64_t>(b & ((1u << SubBits) - 1)) | (1u << SubBits)) << shift;
+        return static_cast<int64_t>(low + (uint64_t(1) << shift) - 1);
+    }
+};
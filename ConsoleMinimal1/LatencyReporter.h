@@ -0,0 +1,128 @@
+#pragma once
+#include "LatencyHistogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Timings of one publish pipeline. Each histogram has a single writer: the
+// sampler thread for the first three, an endpoint's publish thread for the rest.
+struct PublishLatency {
+    LatencyHistogram read;    // readInto()
+    LatencyHistogram period;  // between consecutive samples
+    LatencyHistogram jitter;  // |period - DELAY_MS|
+    LatencyHistogram queue;   // sample to dequeue by the publisher
+    LatencyHistogram build;   // variant update and change selection
+    LatencyHistogram write;   // sync: the write round trip; async: handing the request over
+    LatencyHistogram iterate; // UA_Client_run_iterate after a write
+    LatencyHistogram cycle;   // dequeue to end of the publish cycle
+    LatencyHistogram age;     // sample to write acknowledgement
+};
+
+// Writes a percentile table of every stage from its own thread: the last
+// interval every intervalSec (0 = never), and totals since start on stop().
+// One block per added pipeline (the sampler, each endpoint); stages that
+// never ran in a pipeline are left out. Goes to logPath (appended) or stderr
+// when that is empty, which only suits a console without the status screen.
+class LatencyReporter {
+public:
+    LatencyReporter(int intervalSec, const std::string& logPath)
+        : interval(intervalSec), path(logPath), started(std::chrono::steady_clock::now()) {}
+    ~LatencyReporter() { stop(); }
+
+    // Before start()
+    void add(const std::string& name, const PublishLatency& stages) { groups.push_back(Group{ name, &stages }); }
+
+    void start() {
+        running = true;
+        if (interval.count() > 0) worker = std::thread([this] { run(); });
+    }
+
+    void stop() {
+        if (!running.exchange(false)) return;
+        if (worker.joinable()) worker.join();
+        std::vector<Totals> now = take();
+        write(now, std::vector<Totals>(now.size()), "since start", std::chrono::steady_clock::now() - started);
+    }
+
+private:
+    struct Group {
+        std::string name;
+        const PublishLatency* latency;
+    };
+
+    struct Totals {
+        LatencyHistogram::Snapshot stage[9];
+    };
+
+    std::vector<Group> groups;
+    std::chrono::seconds interval;
+    std::string path;
+    std::chrono::steady_clock::time_point started;
+    std::atomic<bool> running{ false };
+    std::thread worker;
+
+    std::vector<Totals> take() const {
+        std::vector<Totals> all(groups.size());
+        for (size_t g = 0; g < groups.size(); ++g) {
+            const PublishLatency& l = *groups[g].latency;
+            const LatencyHistogram* stages[9] = { &l.read, &l.period, &l.jitter, &l.queue,
+                &l.build, &l.write, &l.iterate, &l.cycle, &l.age };
+            for (int i = 0; i < 9; ++i) all[g].stage[i] = stages[i]->snapshot();
+        }
+        return all;
+    }
+
+    void run() {
+        std::vector<Totals> last = take();
+        auto lastAt = std::chrono::steady_clock::now();
+        auto due = lastAt + interval;
+        while (running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100)); // short naps so stop() is prompt
+            auto now = std::chrono::steady_clock::now();
+            if (now < due) continue;
+            due += interval;
+            std::vector<Totals> totals = take();
+            write(totals, last, "last interval", now - lastAt);
+            last = totals;
+            lastAt = now;
+        }
+    }
+
+    void write(const std::vector<Totals>& now, const std::vector<Totals>& before, const char* span,
+               std::chrono::steady_clock::duration spanTime) const {
+        static const char* names[9] = { "read", "period", "jitter", "queue", "build", "write", "iterate", "cycle", "age" };
+        long long elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - started).count();
+        double seconds = std::chrono::duration<double>(spanTime).count();
+
+        std::string text;
+        char line[192];
+        std::snprintf(line, sizeof(line), "Latency at +%lld s (%s), microseconds:\n", elapsed, span);
+        text += line;
+        for (size_t g = 0; g < groups.size(); ++g) {
+            text += "  " + groups[g].name + "\n";
+            std::snprintf(line, sizeof(line), "  %-8s %10s %8s %9s %9s %9s %9s %9s %9s\n", "stage", "count", "per s",
+                "mean", "p50", "p90", "p99", "p99.9", "max");
+            text += line;
+            for (int i = 0; i < 9; ++i) {
+                if (now[g].stage[i].total == 0) continue;
+                LatencyHistogram::Snapshot d = now[g].stage[i] - before[g].stage[i];
+                std::snprintf(line, sizeof(line), "  %-8s %10llu %8.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", names[i],
+                    static_cast<unsigned long long>(d.total), seconds > 0 ? d.total / seconds : 0.0,
+                    d.meanNs() / 1000.0, d.percentileNs(0.50) / 1000.0, d.percentileNs(0.90) / 1000.0,
+                    d.percentileNs(0.99) / 1000.0, d.percentileNs(0.999) / 1000.0, d.maxNs() / 1000.0);
+                text += line;
+            }
+        }
+
+        if (path.empty()) { std::cerr << text; return; }
+        std::ofstream out(path, std::ios::app);
+        if (!out) { std::cerr << "Cannot write latency log: " << path << "\n"; return; }
+        out << text;
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A file mapped into memory, either created at a fixed size for writing
+// (space is reserved up front so appends never grow the file) or opened
+// read-only. close() can trim a written file to the bytes actually used.
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool create(const std::string& path, size_t size) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) { file = nullptr; return false; }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size), nullptr);
+        if (!mapping) { close(); return false; }
+        base = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size));
+        if (!base) { close(); return false; }
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        // Reserve the blocks now, not on first touch; not every filesystem can
+        if (posix_fallocate(fd, 0, static_cast<off_t>(size)) != 0 && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(); return false;
+        }
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) { close(); return false; }
+        base = static_cast<unsigned char*>(p);
+#endif
+        mappedSize = size;
+        writable = true;
+        return true;
+    }
+
+    bool openRead(const std::string& path) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) { file = nullptr; return false; }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { close(); return false; }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) { close(); return false; }
+        base = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!base) { close(); return false; }
+        mappedSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { close(); return false; }
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) { close(); return false; }
+        base = static_cast<unsigned char*>(p);
+        mappedSize = static_cast<size_t>(st.st_size);
+#endif
+        writable = false;
+        return true;
+    }
+
+    // keepBytes > 0 trims a created file to that length after unmapping
+    void close(size_t keepBytes = 0) {
+#ifdef _WIN32
+        if (base) { if (writable) FlushViewOfFile(base, 0); UnmapViewOfFile(base); base = nullptr; }
+        if (mapping) { CloseHandle(mapping); mapping = nullptr; }
+        if (file) {
+            if (writable && keepBytes > 0) {
+                LARGE_INTEGER end;
+                end.QuadPart = static_cast<LONGLONG>(keepBytes);
+                if (SetFilePointerEx(file, end, nullptr, FILE_BEGIN)) SetEndOfFile(file);
+            }
+            CloseHandle(file);
+            file = nullptr;
+        }
+#else
+        if (base) { munmap(base, mappedSize); base = nullptr; }
+        if (fd >= 0) {
+            if (writable && keepBytes > 0 && ftruncate(fd, static_cast<off_t>(keepBytes)) != 0) {
+                // leave the file at its preallocated size, readers go by the header
+            }
+            ::close(fd);
+            fd = -1;
+        }
+#endif
+        mappedSize = 0;
+        writable = false;
+    }
+
+    unsigned char* data() { return base; }
+    const unsigned char* data() const { return base; }
+    size_t size() const { return mappedSize; }
+    bool isOpen() const { return base != nullptr; }
+
+private:
+    unsigned char* base{ nullptr };
+    size_t mappedSize{ 0 };
+    bool writable{ false };
+#ifdef _WIN32
+    HANDLE file{ nullptr };
+    HANDLE mapping{ nullptr };
+#else
+    int fd{ -1 };
+#endif
+};
@@ -0,0 +1,230 @@
+#pragma once
+#include <open62541/client.h>
+#include "ACSharedOut.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Backing storage for a LapTime field's UA_String
+struct LapTimeText {
+    char chars[16];
+    UA_String str;
+};
+
+// Unix-epoch nanoseconds as an OPC UA DateTime (100 ns ticks since 1601)
+inline UA_DateTime toUaDateTime(int64_t utcNs) {
+    return UA_DATETIME_UNIX_EPOCH + utcNs / 100;
+}
+
+// The request never reached the server, or its answer cannot arrive, so
+// it is worth sending again once reconnected. Not BadTimeout: a timed-out
+// write may have been applied, and sending it again would write it twice.
+inline bool linkLost(UA_StatusCode sc) {
+    return sc == UA_STATUSCODE_BADCONNECTIONCLOSED || sc == UA_STATUSCODE_BADSECURECHANNELCLOSED ||
+        sc == UA_STATUSCODE_BADSESSIONIDINVALID || sc == UA_STATUSCODE_BADSERVERNOTCONNECTED ||
+        sc == UA_STATUSCODE_BADSHUTDOWN;
+}
+
+// Points w's variant at field f's storage: its values in the snapshot-shaped
+// array values, or text for a LapTime. ACValue is 4 bytes, so a run of
+// slots is a plain Int32/Float array.
+inline void bindWriteValue(UA_WriteValue& w, const ACField& f, ACValue* values, LapTimeText& text) {
+    ACValue* v = &values[f.slot];
+    switch (f.type) {
+    case ACValueType::Int32:
+        if (f.count > 1) UA_Variant_setArray(&w.value.value, &v->i, f.count, &UA_TYPES[UA_TYPES_INT32]);
+        else UA_Variant_setScalar(&w.value.value, &v->i, &UA_TYPES[UA_TYPES_INT32]);
+        break;
+    case ACValueType::Float:
+        if (f.count > 1) UA_Variant_setArray(&w.value.value, &v->f, f.count, &UA_TYPES[UA_TYPES_FLOAT]);
+        else UA_Variant_setScalar(&w.value.value, &v->f, &UA_TYPES[UA_TYPES_FLOAT]);
+        break;
+    case ACValueType::LapTime:
+        text.chars[0] = '\0';
+        text.str.length = 0;
+        text.str.data = reinterpret_cast<UA_Byte*>(text.chars);
+        UA_Variant_setScalar(&w.value.value, &text.str, &UA_TYPES[UA_TYPES_STRING]);
+        break;
+    }
+    // Storage is ours, never let open62541 free it
+    w.value.value.storageType = UA_VARIANT_DATA_NODELETE;
+}
+
+// WriteRequest built once for a field table: NodeIds are allocated at
+// build() (and resolveNodeIds()), every variant points into storage owned here. update() only
+// patches that storage, so a publish cycle allocates nothing on our side.
+// Array fields become one array variant over their elements. Every value
+// carries the sample's read time as its source timestamp, so the server
+// keeps the sampling moment rather than the arrival time.
+class PreparedWrite {
+public:
+    PreparedWrite() { UA_WriteRequest_init(&req); }
+    ~PreparedWrite() { clear(); }
+
+    PreparedWrite(const PreparedWrite&) = delete;
+    PreparedWrite& operator=(const PreparedWrite&) = delete;
+
+    bool build(const ACField* table, size_t count) {
+        clear();
+        fields = table;
+        values.assign(acValueCount(table, count), ACValue());
+        times.resize(count);
+        configuredIds.resize(count);
+        writeValues.resize(count);
+        sendValues.resize(count);
+        sendIndex.resize(count);
+
+        for (size_t k = 0; k < count; ++k) {
+            UA_WriteValue& w = writeValues[k];
+            UA_WriteValue_init(&w);
+            configuredIds[k] = UA_NODEID_STRING_ALLOC(3, fields[k].nodeId);
+            if (configuredIds[k].identifier.string.length == 0 ||
+                UA_NodeId_copy(&configuredIds[k], &w.nodeId) != UA_STATUSCODE_GOOD) { clear(); return false; }
+            w.attributeId = UA_ATTRIBUTEID_VALUE;
+            w.value.hasValue = true;
+            w.value.hasSourceTimestamp = stamped;
+
+            bindWriteValue(w, fields[k], values.data(), times[k]);
+        }
+
+        select(nullptr);
+        return true;
+    }
+
+    // Register every configured node in one RegisterNodes request and write
+    // to the ids the server hands back from then on. Servers that optimize
+    // registered nodes return numeric or opaque handles, smaller on the wire
+    // and cheaper to look up than the string ids; others return the
+    // configured ids unchanged, which leaves registered at 0 (reading the
+    // NodeId attribute would only echo the string id). Registrations last
+    // for the session: call again after every reconnect. Anything but GOOD
+    // means the service failed and every node is back on its configured id,
+    // the previous session's handles are no longer valid.
+    UA_StatusCode resolveNodeIds(UA_Client* client, size_t& registered) {
+        registered = 0;
+        if (writeValues.empty()) return UA_STATUSCODE_GOOD;
+
+        UA_RegisterNodesRequest rr; UA_RegisterNodesRequest_init(&rr);
+        rr.nodesToRegister = configuredIds.data(); // shallow, still owned by configuredIds
+        rr.nodesToRegisterSize = configuredIds.size();
+
+        UA_RegisterNodesResponse resp = UA_Client_Service_registerNodes(client, rr);
+        UA_StatusCode sc = resp.responseHeader.serviceResult;
+        if (sc == UA_STATUSCODE_GOOD && resp.registeredNodeIdsSize != configuredIds.size())
+            sc = UA_STATUSCODE_BADUNEXPECTEDERROR;
+        for (size_t k = 0; k < writeValues.size(); ++k) {
+            const UA_NodeId* handle = sc == UA_STATUSCODE_GOOD ? &resp.registeredNodeIds[k] : nullptr;
+            bool useHandle = handle && !UA_NodeId_isNull(handle) && !UA_NodeId_equal(handle, &configuredIds[k]);
+            UA_NodeId_clear(&writeValues[k].nodeId);
+            if (useHandle && UA_NodeId_copy(handle, &writeValues[k].nodeId) == UA_STATUSCODE_GOOD) {
+                ++registered;
+                continue;
+            }
+            UA_NodeId_clear(&writeValues[k].nodeId);
+            UA_NodeId_copy(&configuredIds[k], &writeValues[k].nodeId);
+        }
+
+        UA_RegisterNodesResponse_clear(&resp);
+        select(nullptr); // sendValues held the old ids
+        return sc;
+    }
+
+    // Source timestamps on or off (some servers refuse them); before build()
+    void setSourceTimestamps(bool on) { stamped = on; }
+
+    // Copy one snapshot into the request payloads
+    void update(const ACSharedOutData& snap) {
+        std::memcpy(values.data(), snap.values, values.size() * sizeof(ACValue));
+        for (size_t k = 0; k < writeValues.size(); ++k) {
+            if (fields[k].type == ACValueType::LapTime)
+                times[k].str.length = formatLapTime(snap.values[fields[k].slot].i, times[k].chars, sizeof(times[k].chars));
+        }
+        if (!stamped) return;
+        // The timestamp lives in the DataValue itself, so the selected copies need it too
+        UA_DateTime ts = toUaDateTime(snap.sampledUtcNs);
+        for (auto& w : writeValues) w.value.sourceTimestamp = ts;
+        for (size_t i = 0; i < req.nodesToWriteSize; ++i) sendValues[i].value.sourceTimestamp = ts;
+    }
+
+    // Limit the next send() to fields with mask[k] set; nullptr selects all.
+    // Selected entries are shallow copies into a preallocated array, so this
+    // does not allocate either. Returns the number of fields selected.
+    size_t select(const uint8_t* mask) {
+        size_t n = 0;
+        for (size_t k = 0; k < writeValues.size(); ++k) {
+            if (mask && !mask[k]) continue;
+            sendValues[n] = writeValues[k];
+            sendIndex[n] = k;
+            ++n;
+        }
+        UA_WriteRequest_init(&req);
+        req.nodesToWrite = sendValues.data();
+        req.nodesToWriteSize = n;
+        return n;
+    }
+
+    // Synchronous write of the selected payloads; logs per-item failures.
+    // Nothing selected counts as success.
+    bool send(UA_Client* client) {
+        if (writeValues.empty()) return false;
+        if (req.nodesToWriteSize == 0) return true;
+
+        UA_WriteResponse resp = UA_Client_Service_write(client, req);
+        bool ok = (resp.responseHeader.serviceResult == UA_STATUSCODE_GOOD) && (resp.resultsSize == req.nodesToWriteSize);
+        if (ok) {
+            for (size_t i = 0; i < resp.resultsSize; ++i) {
+                if (resp.results[i] != UA_STATUSCODE_GOOD) {
+                    std::cerr << "Batch write failed at " << i << " (ns=3;s:" << fields[sendIndex[i]].nodeId
+                        << ") status=0x" << std::hex << (unsigned)resp.results[i] << std::dec << "\n";
+                    ok = false;
+                }
+            }
+        }
+        else {
+            std::cerr << "Batch write request failed: status=0x" << std::hex
+                << (unsigned)resp.responseHeader.serviceResult << std::dec << "\n";
+        }
+
+        UA_WriteResponse_clear(&resp);
+        return ok;
+    }
+
+    // Asynchronous write of the selected payloads. open62541 encodes the
+    // request before returning, so update()/select() may run again at once.
+    UA_StatusCode sendAsync(UA_Client* client, UA_ClientAsyncWriteCallback callback, void* userdata, UA_UInt32* requestId) {
+        return UA_Client_sendAsyncWriteRequest(client, &req, callback, userdata, requestId);
+    }
+
+    const UA_WriteRequest& request() const { return req; }
+    size_t selected() const { return req.nodesToWriteSize; }
+    size_t size() const { return writeValues.size(); }
+    const char* text(size_t k) const { return times[k].chars; } // last formatted LapTime
+    size_t selectedField(size_t i) const { return sendIndex[i]; } // field index of request entry i
+    const char* nodeName(size_t k) const { return fields[k].nodeId; }
+    const UA_NodeId& nodeId(size_t k) const { return writeValues[k].nodeId; } // as written (resolved or configured)
+
+    void clear() {
+        for (auto& w : writeValues) UA_NodeId_clear(&w.nodeId);
+        for (auto& id : configuredIds) UA_NodeId_clear(&id);
+        writeValues.clear();
+        configuredIds.clear();
+        sendValues.clear();
+        sendIndex.clear();
+        values.clear();
+        times.clear();
+        UA_WriteRequest_init(&req);
+        fields = nullptr;
+    }
+
+private:
+    const ACField* fields{ nullptr };
+    bool stamped{ true };
+    std::vector<ACValue> values;           // per snapshot value
+    std::vector<LapTimeText> times;
+    std::vector<UA_NodeId> configuredIds; // ns=3 string ids from the field table
+    std::vector<UA_WriteValue> writeValues;
+    std::vector<UA_WriteValue> sendValues; // selected subset, shallow copies of writeValues
+    std::vector<size_t> sendIndex;         // field index of each sendValues entry
+    UA_WriteRequest req;
+};
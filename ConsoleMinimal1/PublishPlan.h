@@ -0,0 +1,351 @@
+#pragma once
+#include "ACSharedOut.h"
+
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A numeric member of one of the AC pages, addressable from a tag map
+struct ACPageField {
+    const char* name;
+    ACPage page;
+    size_t offset;
+    ACSourceType type;
+    size_t count; // array length, 1 for scalars
+};
+
+#define AC_PHYSICS_FIELD(f, t) { #f, ACPage::Physics, offsetof(SPageFilePhysics, f), ACSourceType::t, sizeof(SPageFilePhysics::f) / 4 }
+#define AC_GRAPHICS_FIELD(f, t) { #f, ACPage::Graphics, offsetof(SPageFileGraphics, f), ACSourceType::t, sizeof(SPageFileGraphics::f) / 4 }
+
+// Every numeric field of SPageFilePhysics / SPageFileGraphics (strings excluded)
+constexpr ACPageField acPageFields[] = {
+    AC_PHYSICS_FIELD(packetId, Int32),
+    AC_PHYSICS_FIELD(gas, Float),
+    AC_PHYSICS_FIELD(brake, Float),
+    AC_PHYSICS_FIELD(fuel, Float),
+    AC_PHYSICS_FIELD(gear, Int32),
+    AC_PHYSICS_FIELD(engineRPM, Int32),
+    AC_PHYSICS_FIELD(steerAngle, Float),
+    AC_PHYSICS_FIELD(speedKmh, Float),
+    AC_PHYSICS_FIELD(velocity, Float),
+    AC_PHYSICS_FIELD(accG, Float),
+    AC_PHYSICS_FIELD(wheelSlip, Float),
+    AC_PHYSICS_FIELD(wheelLoad, Float),
+    AC_PHYSICS_FIELD(wheelsPressure, Float),
+    AC_PHYSICS_FIELD(wheelAngularSpeed, Float),
+    AC_PHYSICS_FIELD(tyreWear, Float),
+    AC_PHYSICS_FIELD(tyreDirtyLevel, Float),
+    AC_PHYSICS_FIELD(tyreCoreTemperature, Float),
+    AC_PHYSICS_FIELD(camberRAD, Float),
+    AC_PHYSICS_FIELD(suspensionTravel, Float),
+    AC_PHYSICS_FIELD(drs, Float),
+    AC_PHYSICS_FIELD(tc, Float),
+    AC_PHYSICS_FIELD(heading, Float),
+    AC_PHYSICS_FIELD(pitch, Float),
+    AC_PHYSICS_FIELD(roll, Float),
+    AC_PHYSICS_FIELD(cgHeight, Float),
+    AC_PHYSICS_FIELD(carDamage, Float),
+    AC_PHYSICS_FIELD(numberOfTyresOut, Int32),
+    AC_PHYSICS_FIELD(pitLimiterOn, Int32),
+    AC_PHYSICS_FIELD(abs, Float),
+    AC_PHYSICS_FIELD(kersCharge, Float),
+    AC_PHYSICS_FIELD(kersInput, Float),
+    AC_PHYSICS_FIELD(autoShifterOn, Int32),
+    AC_PHYSICS_FIELD(rideHeight, Float),
+    AC_PHYSICS_FIELD(turboBoost, Float),
+    AC_PHYSICS_FIELD(ballast, Float),
+    AC_PHYSICS_FIELD(airDensity, Float),
+    AC_PHYSICS_FIELD(airTemp, Float),
+    AC_PHYSICS_FIELD(roadTemp, Float),
+    AC_PHYSICS_FIELD(localAngularVel, Float),
+    AC_PHYSICS_FIELD(finalFF, Float),
+    AC_PHYSICS_FIELD(performanceMeter, Float),
+    AC_PHYSICS_FIELD(engineBrake, Int32),
+    AC_PHYSICS_FIELD(ersRecoveryLevel, Int32),
+    AC_PHYSICS_FIELD(ersPowerLevel, Int32),
+    AC_PHYSICS_FIELD(ersHeatCharging, Int32),
+    AC_PHYSICS_FIELD(ersIsCharging, Int32),
+    AC_PHYSICS_FIELD(kersCurrentKJ, Float),
+    AC_PHYSICS_FIELD(drsAvailable, Int32),
+    AC_PHYSICS_FIELD(drsEnabled, Int32),
+    AC_PHYSICS_FIELD(brakeTemp, Float),
+    AC_PHYSICS_FIELD(clutch, Float),
+    AC_PHYSICS_FIELD(tyreTempI, Float),
+    AC_PHYSICS_FIELD(tyreTempM, Float),
+    AC_PHYSICS_FIELD(tyreTempO, Float),
+    AC_PHYSICS_FIELD(isAIControlled, Int32),
+    AC_PHYSICS_FIELD(tyreContactPoint, Float),
+    AC_PHYSICS_FIELD(tyreContactNormal, Float),
+    AC_PHYSICS_FIELD(tyreContactHeading, Float),
+    AC_PHYSICS_FIELD(brakeBias, Float),
+    AC_PHYSICS_FIELD(localVelocity, Float),
+    AC_GRAPHICS_FIELD(packetId, Int32),
+    AC_GRAPHICS_FIELD(status, Int32),
+    AC_GRAPHICS_FIELD(session, Int32),
+    AC_GRAPHICS_FIELD(completedLaps, Int32),
+    AC_GRAPHICS_FIELD(position, Int32),
+    AC_GRAPHICS_FIELD(iCurrentTime, Int32),
+    AC_GRAPHICS_FIELD(iLastTime, Int32),
+    AC_GRAPHICS_FIELD(iBestTime, Int32),
+    AC_GRAPHICS_FIELD(sessionTimeLeft, Float),
+    AC_GRAPHICS_FIELD(distanceTraveled, Float),
+    AC_GRAPHICS_FIELD(isInPit, Int32),
+    AC_GRAPHICS_FIELD(currentSectorIndex, Int32),
+    AC_GRAPHICS_FIELD(lastSectorTime, Int32),
+    AC_GRAPHICS_FIELD(numberOfLaps, Int32),
+    AC_GRAPHICS_FIELD(replayTimeMultiplier, Float),
+    AC_GRAPHICS_FIELD(normalizedCarPosition, Float),
+    AC_GRAPHICS_FIELD(carCoordinates, Float),
+    AC_GRAPHICS_FIELD(penaltyTime, Float),
+    AC_GRAPHICS_FIELD(flag, Int32),
+    AC_GRAPHICS_FIELD(idealLineOn, Int32),
+    AC_GRAPHICS_FIELD(isInPitLane, Int32),
+    AC_GRAPHICS_FIELD(surfaceGrip, Float),
+    AC_GRAPHICS_FIELD(mandatoryPitDone, Int32),
+    AC_GRAPHICS_FIELD(windSpeed, Float),
+    AC_GRAPHICS_FIELD(windDirection, Float),
+};
+
+#undef AC_PHYSICS_FIELD
+#undef AC_GRAPHICS_FIELD
+
+#define AC_DERIVED_FIELD(f, t) { #f, ACPage::Derived, offsetof(ACDerivedPage, f), ACSourceType::t, sizeof(ACDerivedPage::f) / 4 }
+
+// Lap analytics, tag map sources derived.<name>
+constexpr ACPageField acDerivedFields[] = {
+    AC_DERIVED_FIELD(fuelLastLap, Float),
+    AC_DERIVED_FIELD(fuelPerLap, Float),
+    AC_DERIVED_FIELD(fuelLapsLeft, Float),
+    AC_DERIVED_FIELD(deltaToBest, Float),
+    AC_DERIVED_FIELD(sectorTimes, Int32),
+    AC_DERIVED_FIELD(lastLapSectorTimes, Int32),
+    AC_DERIVED_FIELD(bestSectorTimes, Int32),
+    AC_DERIVED_FIELD(tyreTempAvg, Float),
+};
+
+#undef AC_DERIVED_FIELD
+
+// Immutable list of published tags, compiled once at startup from the
+// built-in mapping or a tag map file. Everything downstream (reads, change
+// filter, write request) works off fields(), so adding tags costs no
+// per-tick parsing or lookups.
+//
+// Tag map format, one tag per line ('#' starts a comment):
+//   nodeId,source,type[,scale[,offset[,name[,aggregate]]]]
+//   719:Car.speed,physics.speedKmh,int32,1,0,speedKmh
+//   719:Car.rpmMax,physics.engineRPM,int32,1,0,rpmMax,max
+// source is physics.<field>, graphics.<field> or derived.<name> (lap
+// analytics, see acDerivedFields); an array field is published whole as one
+// array variant, or one element with [n].
+// type is int32, float or laptime (scalars only).
+// published = source * scale + offset; name defaults to the field name.
+// aggregate (min, max, mean or last) publishes that statistic over every
+// physics frame since the previous sample instead of the sampled value.
+class PublishPlan {
+public:
+    PublishPlan() = default;
+
+    // entries point into text, a copy would point into the source
+    PublishPlan(const PublishPlan&) = delete;
+    PublishPlan& operator=(const PublishPlan&) = delete;
+
+    void useDefaults() {
+        entries.clear();
+        text.clear();
+        values = 0;
+        for (const ACField& field : acDefaultFields) add(field);
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) { std::cerr << "Cannot open tag map: " << path << "\n"; return false; }
+        return parse(file, path);
+    }
+
+    // Tag map text from any stream; origin prefixes error messages
+    bool parse(std::istream& in, const std::string& origin) {
+        entries.clear();
+        text.clear();
+        values = 0;
+        std::string line;
+        for (int lineNo = 1; std::getline(in, line); ++lineNo) {
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            std::vector<std::string> cols = split(line);
+            if (cols.empty() || (cols.size() == 1 && cols[0].empty())) continue;
+            if (cols[0] == "nodeId") continue; // header row
+
+            std::string error;
+            if (!addTag(cols, error)) {
+                std::cerr << origin << ":" << lineNo << ": " << error << "\n";
+                return false;
+            }
+        }
+        if (entries.empty()) { std::cerr << origin << ": no tags\n"; return false; }
+        return true;
+    }
+
+    // Appends every tag of base for one more rig: new slots, names kept (so
+    // deadbands and the display apply to every rig) and each node id's
+    // object, the part before its first ':', swapped per objectIds
+    // (e.g. 719 -> 801). False, with error set, once the snapshot would
+    // overflow or a node id is already taken by an earlier rig (an object
+    // the swaps leave alone would be written by both rigs).
+    bool addRig(const PublishPlan& base, const std::vector<std::pair<std::string, std::string>>& objectIds, std::string& error) {
+        if (values + base.values > ACMaxValues) {
+            error = "copies of the tag map exceed " + std::to_string(ACMaxValues) + " values";
+            return false;
+        }
+        std::set<std::string> taken;
+        for (const ACField& field : entries) taken.insert(field.nodeId);
+        size_t firstEntry = entries.size();
+        size_t firstValue = values;
+        for (const ACField& source : base.entries) {
+            ACField field = source;
+            std::string nodeId = source.nodeId;
+            size_t colon = nodeId.find(':');
+            if (colon != std::string::npos) {
+                for (const auto& swap : objectIds)
+                    if (nodeId.compare(0, colon, swap.first) == 0) { nodeId = swap.second + nodeId.substr(colon); break; }
+            }
+            if (taken.count(nodeId)) {
+                error = "node id " + nodeId + " is already published by an earlier rig, map its object id";
+                entries.resize(firstEntry);
+                values = firstValue;
+                return false;
+            }
+            field.nodeId = keep(nodeId);
+            field.name = keep(source.name);
+            add(field);
+        }
+        return true;
+    }
+
+    // Tags [first, first + count) of plan with their slots unchanged, for a
+    // publisher that sends part of a shared snapshot; plan must outlive this
+    void slice(const PublishPlan& plan, size_t first, size_t count) {
+        entries.assign(plan.entries.begin() + first, plan.entries.begin() + first + count);
+        text.clear();
+        values = acValueCount(entries.data(), entries.size());
+    }
+
+    const ACField* fields() const { return entries.data(); }
+    size_t size() const { return entries.size(); }
+    size_t valueCount() const { return values; } // snapshot values, array elements included
+
+    // Index of the first tag called name, or -1 (startup only)
+    int find(const char* name) const {
+        for (size_t k = 0; k < entries.size(); ++k)
+            if (std::string(entries[k].name) == name) return static_cast<int>(k);
+        return -1;
+    }
+
+private:
+    std::vector<ACField> entries;
+    std::deque<std::string> text; // owns the names/node ids entries point at
+    size_t values{ 0 };
+
+    void add(ACField field) {
+        field.slot = static_cast<uint32_t>(values);
+        values += field.count;
+        entries.push_back(field);
+    }
+
+    static std::vector<std::string> split(const std::string& line) {
+        std::vector<std::string> cols;
+        size_t pos = 0;
+        for (;;) {
+            size_t comma = line.find(',', pos);
+            std::string col = line.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+            size_t b = col.find_first_not_of(" \t\r");
+            size_t e = col.find_last_not_of(" \t\r");
+            cols.push_back(b == std::string::npos ? std::string() : col.substr(b, e - b + 1));
+            if (comma == std::string::npos) break;
+            pos = comma + 1;
+        }
+        return cols;
+    }
+
+    static bool parseFloat(const std::string& s, float& out) {
+        char* end = nullptr;
+        out = std::strtof(s.c_str(), &end);
+        return !s.empty() && *end == '\0';
+    }
+
+    const char* keep(const std::string& s) {
+        text.push_back(s);
+        return text.back().c_str();
+    }
+
+    bool addTag(const std::vector<std::string>& cols, std::string& error) {
+        if (cols.size() < 3 || cols.size() > 7) { error = "expected nodeId,source,type[,scale[,offset[,name[,aggregate]]]]"; return false; }
+
+        ACField field{};
+        field.nodeId = keep(cols[0]);
+        if (cols[0].empty()) { error = "empty nodeId"; return false; }
+
+        // source: <page>.<field>[<index>]
+        const std::string& source = cols[1];
+        size_t dot = source.find('.');
+        std::string pageName = dot == std::string::npos ? std::string() : source.substr(0, dot);
+        if (pageName == "physics") field.page = ACPage::Physics;
+        else if (pageName == "graphics") field.page = ACPage::Graphics;
+        else if (pageName == "derived") field.page = ACPage::Derived;
+        else { error = "source must start with physics., graphics. or derived."; return false; }
+
+        std::string member = source.substr(dot + 1);
+        size_t index = 0;
+        bool indexed = false;
+        size_t bracket = member.find('[');
+        if (bracket != std::string::npos) {
+            char* end = nullptr;
+            index = std::strtoul(member.c_str() + bracket + 1, &end, 10);
+            if (*end != ']' || end[1] != '\0') { error = "bad index in '" + source + "'"; return false; }
+            member.erase(bracket);
+            indexed = true;
+        }
+
+        const ACPageField* pf = nullptr;
+        for (const ACPageField& candidate : acPageFields)
+            if (candidate.page == field.page && member == candidate.name) { pf = &candidate; break; }
+        for (const ACPageField& candidate : acDerivedFields)
+            if (candidate.page == field.page && member == candidate.name) { pf = &candidate; break; }
+        if (!pf) { error = "unknown field '" + source + "'"; return false; }
+        if (index >= pf->count) { error = "index out of range in '" + source + "'"; return false; }
+        field.offset = pf->offset + index * 4;
+        field.source = pf->type;
+        field.count = indexed ? 1 : static_cast<uint32_t>(pf->count);
+        if (values + field.count > ACMaxValues) { error = "too many values"; return false; }
+
+        const std::string& type = cols[2];
+        if (type == "int32") field.type = ACValueType::Int32;
+        else if (type == "float") field.type = ACValueType::Float;
+        else if (type == "laptime") field.type = ACValueType::LapTime;
+        else { error = "unknown type '" + type + "'"; return false; }
+        if (field.type == ACValueType::LapTime && field.count > 1) { error = "laptime needs a scalar source, pick an element with [n]"; return false; }
+
+        field.scale = 1.0f;
+        field.bias = 0.0f;
+        if (cols.size() > 3 && !cols[3].empty() && !parseFloat(cols[3], field.scale)) { error = "bad scale"; return false; }
+        if (cols.size() > 4 && !cols[4].empty() && !parseFloat(cols[4], field.bias)) { error = "bad offset"; return false; }
+        field.name = keep(cols.size() > 5 && !cols[5].empty() ? cols[5] : source.substr(dot + 1));
+
+        const std::string aggregate = cols.size() > 6 ? cols[6] : std::string();
+        if (aggregate.empty()) field.aggregate = ACAggregate::None;
+        else if (aggregate == "min") field.aggregate = ACAggregate::Min;
+        else if (aggregate == "max") field.aggregate = ACAggregate::Max;
+        else if (aggregate == "mean") field.aggregate = ACAggregate::Mean;
+        else if (aggregate == "last") field.aggregate = ACAggregate::Last;
+        else { error = "unknown aggregate '" + aggregate + "'"; return false; }
+        if (field.aggregate != ACAggregate::None && field.type == ACValueType::LapTime) { error = "laptime tags cannot be aggregated"; return false; }
+        if (field.aggregate != ACAggregate::None && field.page == ACPage::Derived) { error = "derived tags cannot be aggregated"; return false; }
+
+        add(field);
+        return true;
+    }
+};
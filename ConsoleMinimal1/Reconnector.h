@@ -0,0 +1,101 @@
+#pragma once
+#include <open62541/client.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+// Re-establishes the secure channel and session after the connection drops.
+// Connect attempts block for up to the client timeout, so they run on their
+// own thread; from start() until poll() reports success the publish loop
+// must leave the client alone. Waits between attempts double from minDelay
+// to maxDelay, with +-20% jitter so several bridges do not retry in step.
+class Reconnector {
+public:
+    // name prefixes the log lines, like the endpoint's own
+    Reconnector(const std::string& name, UA_Client* uaClient, const std::string& endpointUrl, const std::string& user,
+                const std::string& pass, int minDelayMs, int maxDelayMs)
+        : label(name), client(uaClient), endpoint(endpointUrl), username(user), password(pass),
+          minDelay(minDelayMs < 1 ? 1 : minDelayMs), maxDelay(maxDelayMs < minDelayMs ? minDelayMs : maxDelayMs),
+          random(static_cast<unsigned>(std::chrono::steady_clock::now().time_since_epoch().count())) {}
+    ~Reconnector() { stop(); }
+
+    // Session state as the client last saw it (publish loop only)
+    bool connected() const {
+        UA_SecureChannelState channel;
+        UA_SessionState session;
+        UA_StatusCode status;
+        UA_Client_getState(client, &channel, &session, &status);
+        return session == UA_SESSIONSTATE_ACTIVATED;
+    }
+
+    // Closes what is left of the connection (pending async requests complete
+    // with a bad status on this thread) and starts reconnecting
+    void start() {
+        if (worker.joinable()) return;
+        UA_Client_disconnect(client);
+        lostAt = std::chrono::steady_clock::now();
+        done = false;
+        stopping = false;
+        worker = std::thread([this] { run(); });
+    }
+
+    // True once, when the session is back; the client is the caller's again
+    bool poll() {
+        if (!worker.joinable() || !done) return false;
+        worker.join();
+        ++reconnectCount;
+        lastOutage = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lostAt);
+        return true;
+    }
+
+    void stop() {
+        stopping = true;
+        if (worker.joinable()) worker.join();
+    }
+
+    bool reconnecting() const { return worker.joinable(); }
+    uint64_t attempts() const { return attemptCount; }
+    uint64_t reconnects() const { return reconnectCount; }
+    long long lastOutageMs() const { return static_cast<long long>(lastOutage.count()); }
+
+private:
+    std::string label;
+    UA_Client* client;
+    std::string endpoint;
+    std::string username;
+    std::string password;
+    int minDelay;
+    int maxDelay;
+    std::minstd_rand random; // worker thread only
+    std::thread worker;
+    std::atomic<bool> done{ false };
+    std::atomic<bool> stopping{ false };
+    std::atomic<uint64_t> attemptCount{ 0 };
+    uint64_t reconnectCount{ 0 };
+    std::chrono::steady_clock::time_point lostAt;
+    std::chrono::milliseconds lastOutage{ 0 };
+
+    void run() {
+        int delay = minDelay;
+        while (!stopping) {
+            ++attemptCount;
+            UA_StatusCode sc = UA_Client_connectUsername(client, endpoint.c_str(), username.c_str(), password.c_str());
+            if (sc == UA_STATUSCODE_GOOD) { done = true; return; }
+            UA_Client_disconnect(client);
+
+            std::uniform_int_distribution<int> jitter(-delay / 5, delay / 5);
+            int wait = delay + jitter(random);
+            std::cerr << "[" << label << "] Reconnect failed: 0x" << std::hex << sc << std::dec << ", next attempt in " << wait << " ms\n";
+            auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait);
+            while (!stopping && std::chrono::steady_clock::now() < until)
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            delay = std::min(delay * 2, maxDelay);
+        }
+    }
+};
@@ -0,0 +1,176 @@
+#pragma once
+#include "ACSharedOut.h"
+#include "MappedFile.h"
+#include "Recording.h"
+#include "SpscRing.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// (atomic: written by the recorder threads, read by the display)
+struct RecorderStats {
+    std::atomic<uint64_t> frames{ 0 };   // records written
+    std::atomic<uint64_t> torn{ 0 };     // captures dropped because a page never settled
+    std::atomic<uint64_t> bytes{ 0 };    // bytes written, record headers included
+    std::atomic<uint64_t> rawBytes{ 0 }; // what the same frames take unencoded
+    std::atomic<uint64_t> segments{ 0 };
+    std::atomic<bool> failed{ false };   // a segment could not be created; recording stopped
+};
+
+// Records every physics frame (both pages, raw) into *.acrec segments in
+// directory. One thread polls packetId and copies the pages into a ring;
+// another encodes and appends them to the mapped segment. Neither shares
+// anything with the publish loop but the read-only shared memory.
+class Recorder {
+public:
+    Recorder(ACSharedOut& source, const std::string& directory, size_t segmentBytes, size_t queueFrames = 1024)
+        : ac(source), dir(directory), segmentSize(segmentBytes < minSegment ? minSegment : segmentBytes), ring(queueFrames) {}
+    ~Recorder() { stop(); }
+
+    bool start() {
+        session = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        if (!openSegment()) return false;
+#ifdef _WIN32
+        timeBeginPeriod(1);
+#endif
+        capturing = true;
+        writing = true;
+        captureThread = std::thread([this] { captureLoop(); });
+        writeThread = std::thread([this] { writeLoop(); });
+        return true;
+    }
+
+    // Stops capturing, writes out what is still queued and closes the segment
+    void stop() {
+        if (!captureThread.joinable()) return;
+        capturing = false;
+        captureThread.join();
+        writing = false;
+        writeThread.join();
+        closeSegment();
+#ifdef _WIN32
+        timeEndPeriod(1);
+#endif
+    }
+
+    const RecorderStats& stats() const { return recStats; }
+    uint64_t dropped() const { return ring.dropped(); } // captures the writer fell behind on
+
+private:
+    static const size_t minSegment = 1 << 20;
+
+    ACSharedOut& ac;
+    std::string dir;
+    size_t segmentSize;
+    SpscRing<RecFrame> ring;
+    std::atomic<bool> capturing{ false };
+    std::atomic<bool> writing{ false };
+    std::thread captureThread;
+    std::thread writeThread;
+    RecorderStats recStats;
+
+    // Writer thread only
+    long long session{ 0 };
+    uint32_t segmentIndex{ 0 };
+    MappedFile file;
+    RecSegmentHeader* header{ nullptr };
+    RecFrame prev;
+    bool hasPrev{ false };
+    unsigned char scratch[RecMaxPayload];
+
+    void captureLoop() {
+        RecFrame frame;
+        bool hasLast = false;
+        int lastPacketId = 0;
+        while (capturing.load(std::memory_order_relaxed)) {
+            if (hasLast && ac.physicsPacketId() == lastPacketId) {
+                std::this_thread::sleep_for(std::chrono::microseconds(250));
+                continue;
+            }
+            if (!ac.readPages(frame.physics, frame.graphics)) { ++recStats.torn; continue; }
+            frame.sampledNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            lastPacketId = frame.physics.packetId;
+            hasLast = true;
+            ring.push(frame);
+        }
+    }
+
+    void writeLoop() {
+        RecFrame frame;
+        for (;;) {
+            if (ring.pop(frame)) {
+                if (!recStats.failed && !append(frame)) recStats.failed = true;
+                continue;
+            }
+            if (!writing.load(std::memory_order_acquire)) break; // drained after stop()
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    bool openSegment() {
+        char name[64];
+        std::snprintf(name, sizeof(name), "ac-%lld-%04u.acrec", session, segmentIndex);
+        std::string path = dir.empty() ? std::string(name) : dir + "/" + name;
+        if (!file.create(path, segmentSize)) {
+            std::cerr << "Cannot create recording segment: " << path << "\n";
+            return false;
+        }
+        header = reinterpret_cast<RecSegmentHeader*>(file.data());
+        recInitHeader(*header, segmentIndex);
+        ++segmentIndex;
+        ++recStats.segments;
+        hasPrev = false; // every segment starts with a key frame
+        return true;
+    }
+
+    void closeSegment() {
+        if (!file.isOpen()) return;
+        size_t used = static_cast<size_t>(header->used);
+        header = nullptr;
+        file.close(used);
+    }
+
+    bool append(const RecFrame& frame) {
+        const unsigned char* payload = scratch;
+        size_t size = hasPrev ? recEncodeDelta(frame, prev, scratch) : RecFrameBytes;
+        if (header->used + sizeof(RecRecordHeader) + size > file.size()) {
+            closeSegment();
+            if (!openSegment()) return false;
+            size = RecFrameBytes;
+        }
+        if (!hasPrev) payload = reinterpret_cast<const unsigned char*>(&frame);
+
+        RecRecordHeader rec;
+        rec.size = static_cast<uint32_t>(size);
+        rec.flags = hasPrev ? 0 : RecKeyFrame;
+        rec.physicsPacketId = frame.physics.packetId;
+        rec.graphicsPacketId = frame.graphics.packetId;
+        rec.sampledNs = frame.sampledNs;
+
+        unsigned char* at = file.data() + header->used;
+        std::memcpy(at, &rec, sizeof(rec));
+        std::memcpy(at + sizeof(rec), payload, size);
+        std::atomic_thread_fence(std::memory_order_release); // record before the header says so
+        header->frames += 1;
+        header->used += sizeof(rec) + size;
+
+        prev = frame;
+        hasPrev = true;
+        ++recStats.frames;
+        recStats.bytes += sizeof(rec) + size;
+        recStats.rawBytes += sizeof(rec) + RecFrameBytes;
+        return true;
+    }
+};
@@ -0,0 +1,217 @@
+#pragma once
+#include "ACSharedOut.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// On-disk format of a telemetry recording (*.acrec segment files).
+//
+// A segment is a RecSegmentHeader followed by records. Each record is a
+// RecRecordHeader plus its payload: the first record of a segment is a key
+// frame (both pages verbatim), later ones are XOR deltas against the
+// previous frame. A delta payload is a bitmap of the 4-byte words that
+// changed followed by those words' XOR values; most of the pages stay put
+// between physics steps, so a typical frame shrinks to a few hundred bytes.
+// header.used is advanced after every record, so a segment cut short by a
+// crash is still readable up to its last complete record.
+
+// Both pages as the game wrote them, plus when we copied them
+struct RecFrame {
+    SPageFilePhysics physics;
+    SPageFileGraphics graphics;
+    int64_t sampledNs; // steady_clock
+};
+static_assert(offsetof(RecFrame, graphics) == sizeof(SPageFilePhysics), "pages are encoded as one block");
+
+constexpr size_t RecFrameBytes = sizeof(SPageFilePhysics) + sizeof(SPageFileGraphics);
+constexpr size_t RecFrameWords = RecFrameBytes / 4;
+constexpr size_t RecMaskBytes = (RecFrameWords + 7) / 8;
+constexpr size_t RecMaxPayload = RecMaskBytes + RecFrameBytes; // worst-case delta
+static_assert(RecFrameBytes % 4 == 0, "pages are a whole number of words");
+
+constexpr uint32_t RecVersion = 1;
+constexpr uint32_t RecKeyFrame = 1; // record flag: payload is the raw pages
+
+struct RecSegmentHeader {
+    char magic[8];         // "ACREC\0\0\0"
+    uint32_t version;
+    uint32_t physicsSize;  // sizeof(SPageFilePhysics) at record time
+    uint32_t graphicsSize; // sizeof(SPageFileGraphics) at record time
+    uint32_t segment;      // index within the session
+    uint64_t used;         // bytes of valid data, this header included
+    uint64_t frames;       // records in this segment
+};
+
+struct RecRecordHeader {
+    uint32_t size;  // payload bytes following this header
+    uint32_t flags;
+    int32_t physicsPacketId;
+    int32_t graphicsPacketId;
+    int64_t sampledNs;
+};
+
+inline void recInitHeader(RecSegmentHeader& h, uint32_t segment) {
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, "ACREC", 5);
+    h.version = RecVersion;
+    h.physicsSize = sizeof(SPageFilePhysics);
+    h.graphicsSize = sizeof(SPageFileGraphics);
+    h.segment = segment;
+    h.used = sizeof(RecSegmentHeader);
+}
+
+inline bool recCheckHeader(const RecSegmentHeader& h) {
+    return std::memcmp(h.magic, "ACREC", 5) == 0 && h.version == RecVersion
+        && h.physicsSize == sizeof(SPageFilePhysics) && h.graphicsSize == sizeof(SPageFileGraphics);
+}
+
+// XOR delta of cur against prev into out (at least RecMaxPayload bytes);
+// returns the payload size
+inline size_t recEncodeDelta(const RecFrame& cur, const RecFrame& prev, unsigned char* out) {
+    const unsigned char* a = reinterpret_cast<const unsigned char*>(&cur);
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(&prev);
+    unsigned char* mask = out;
+    unsigned char* words = out + RecMaskBytes;
+    std::memset(mask, 0, RecMaskBytes);
+    for (size_t w = 0; w < RecFrameWords; ++w) {
+        uint32_t x, y;
+        std::memcpy(&x, a + w * 4, 4);
+        std::memcpy(&y, b + w * 4, 4);
+        x ^= y;
+        if (!x) continue;
+        mask[w >> 3] |= static_cast<unsigned char>(1u << (w & 7));
+        std::memcpy(words, &x, 4);
+        words += 4;
+    }
+    return static_cast<size_t>(words - out);
+}
+
+// Applies a delta payload to frame (holding the previous frame) in place.
+// False if the payload does not match its bitmap.
+inline bool recApplyDelta(RecFrame& frame, const unsigned char* payload, size_t size) {
+    if (size < RecMaskBytes) return false;
+    unsigned char* a = reinterpret_cast<unsigned char*>(&frame);
+    const unsigned char* mask = payload;
+    const unsigned char* words = payload + RecMaskBytes;
+    const unsigned char* end = payload + size;
+    for (size_t w = 0; w < RecFrameWords; ++w) {
+        if (!(mask[w >> 3] & (1u << (w & 7)))) continue;
+        if (words + 4 > end) return false;
+        uint32_t x, y;
+        std::memcpy(&x, a + w * 4, 4);
+        std::memcpy(&y, words, 4);
+        x ^= y;
+        std::memcpy(a + w * 4, &x, 4);
+        words += 4;
+    }
+    return words == end;
+}
+
+// Decodes a recording frame by frame. Opened on one segment it carries on
+// with the following ones of the same session (<prefix>-NNNN.acrec).
+class RecordingReader {
+public:
+    bool open(const std::string& firstSegment) {
+        prefix.clear();
+        first = 0;
+        size_t dash = firstSegment.rfind('-');
+        const std::string ext = ".acrec";
+        if (dash != std::string::npos && firstSegment.size() == dash + 5 + ext.size()
+            && firstSegment.compare(dash + 5, ext.size(), ext) == 0) {
+            prefix = firstSegment.substr(0, dash + 1);
+            first = static_cast<uint32_t>(std::strtoul(firstSegment.c_str() + dash + 1, nullptr, 10));
+        }
+        single = prefix.empty() ? firstSegment : std::string();
+        return rewind();
+    }
+
+    // Back to the first frame of the first segment
+    bool rewind() {
+        index = first;
+        bad = false;
+        if (!openSegment(true)) { bad = true; return false; }
+        return true;
+    }
+
+    // Next frame; false at the end of the recording or on a damaged record
+    // (failed() tells which)
+    bool next(RecFrame& frame, RecRecordHeader& rec) {
+        if (!file.isOpen()) return false;
+        while (offset >= used()) {
+            ++index;
+            if (!single.empty()) { file.close(); return false; }
+            if (!openSegment(false)) return false;
+        }
+        if (offset + sizeof(RecRecordHeader) > used()) return fail();
+        std::memcpy(&rec, file.data() + offset, sizeof(rec));
+        offset += sizeof(rec);
+        if (offset + rec.size > used()) return fail();
+
+        const unsigned char* payload = file.data() + offset;
+        offset += rec.size;
+        if (rec.flags & RecKeyFrame) {
+            if (rec.size != RecFrameBytes) return fail();
+            std::memcpy(&current, payload, RecFrameBytes);
+            hasFrame = true;
+        }
+        else if (!hasFrame || !recApplyDelta(current, payload, rec.size)) {
+            return fail();
+        }
+        current.sampledNs = rec.sampledNs;
+        frame = current;
+        return true;
+    }
+
+    bool failed() const { return bad; }
+
+private:
+    std::string prefix; // "<dir>/ac-<session>-" for segment chains
+    std::string single; // path when the name does not follow the pattern
+    uint32_t first{ 0 };
+    uint32_t index{ 0 };
+    MappedFile file;
+    size_t offset{ 0 };
+    RecFrame current;
+    bool hasFrame{ false };
+    bool bad{ false };
+
+    size_t used() const {
+        return static_cast<size_t>(reinterpret_cast<const RecSegmentHeader*>(file.data())->used);
+    }
+
+    bool fail() {
+        bad = true;
+        std::cerr << "Recording damaged in segment " << index << " at byte " << offset << "\n";
+        offset = used(); // skip the rest of this segment
+        return false;
+    }
+
+    bool openSegment(bool required) {
+        std::string path = single;
+        if (path.empty()) {
+            char number[16];
+            std::snprintf(number, sizeof(number), "%04u", index);
+            path = prefix + number + ".acrec";
+        }
+        if (!file.openRead(path)) {
+            if (required) std::cerr << "Cannot open recording: " << path << "\n";
+            return false;
+        }
+        const RecSegmentHeader* h = reinterpret_cast<const RecSegmentHeader*>(file.data());
+        if (file.size() < sizeof(RecSegmentHeader) || !recCheckHeader(*h) || h->used > file.size()) {
+            std::cerr << "Not a recording of this layout: " << path << "\n";
+            file.close();
+            bad = true;
+            return false;
+        }
+        offset = sizeof(RecSegmentHeader);
+        hasFrame = false;
+        return true;
+    }
+};
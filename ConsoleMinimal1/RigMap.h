@@ -0,0 +1,73 @@
+#pragma once
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One simulator rig in multi-rig mode
+struct RigConfig {
+    std::string name;
+    std::string mapping; // shared memory stem, see ACSharedOut::initialize()
+    std::vector<std::pair<std::string, std::string>> objectIds; // Galaxy object swaps, see PublishPlan::addRig()
+};
+
+// Rigs served by one process, each publishing the tag map to its own Galaxy
+// objects. Format, one rig per line ('#' starts a comment):
+//   name,mapping[,object=object...]
+//   rig2,acpmf_rig2,719=801,723=805
+class RigMap {
+public:
+    bool load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) { std::cerr << "Cannot open rig map: " << path << "\n"; return false; }
+        entries.clear();
+        std::string line;
+        for (int lineNo = 1; std::getline(file, line); ++lineNo) {
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            std::vector<std::string> cols = split(line);
+            if (cols.size() == 1 && cols[0].empty()) continue;
+            if (cols[0] == "name") continue; // header row
+
+            RigConfig rig;
+            rig.name = cols[0];
+            rig.mapping = cols.size() > 1 ? cols[1] : std::string();
+            if (rig.name.empty() || rig.mapping.empty()) {
+                std::cerr << path << ":" << lineNo << ": expected name,mapping[,object=object...]\n";
+                return false;
+            }
+            for (size_t c = 2; c < cols.size(); ++c) {
+                size_t eq = cols[c].find('=');
+                if (eq == std::string::npos || eq == 0 || eq + 1 == cols[c].size()) {
+                    std::cerr << path << ":" << lineNo << ": '" << cols[c] << "' is not object=object\n";
+                    return false;
+                }
+                rig.objectIds.emplace_back(cols[c].substr(0, eq), cols[c].substr(eq + 1));
+            }
+            entries.push_back(rig);
+        }
+        if (entries.empty()) { std::cerr << path << ": no rigs\n"; return false; }
+        return true;
+    }
+
+    const std::vector<RigConfig>& rigs() const { return entries; }
+
+private:
+    std::vector<RigConfig> entries;
+
+    static std::vector<std::string> split(const std::string& line) {
+        std::vector<std::string> cols;
+        size_t pos = 0;
+        for (;;) {
+            size_t comma = line.find(',', pos);
+            std::string col = line.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+            size_t b = col.find_first_not_of(" \t\r");
+            size_t e = col.find_last_not_of(" \t\r");
+            cols.push_back(b == std::string::npos ? std::string() : col.substr(b, e - b + 1));
+            if (comma == std::string::npos) break;
+            pos = comma + 1;
+        }
+        return cols;
+    }
+};
@@ -0,0 +1,188 @@
+#pragma once
+#include "ACSharedOut.h"
+#include "MappedFile.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Store-and-forward queue for samples taken while the server is
+// unreachable. Oldest first. Newest samples sit in a memory ring; once that
+// is full the oldest of them move to fixed-size chunk files in spillDir
+// (mapped, written like recording segments), which are read back before
+// anything in memory. Bounded on both sides: past maxSpillBytes the oldest
+// chunk is dropped, without spillDir the oldest sample in memory is.
+// Only the values of the plan are kept, so a record is a few hundred bytes.
+class SampleStore {
+public:
+    SampleStore(size_t valueCount, size_t memorySamples, const std::string& spillDir, size_t maxSpillBytes,
+                size_t chunkBytes = 4 << 20)
+        : values(valueCount), recordBytes(sizeof(Header) + valueCount * sizeof(ACValue)),
+          memory((memorySamples ? memorySamples : 1) * recordBytes), memoryCap(memorySamples ? memorySamples : 1),
+          dir(spillDir), chunkRecords(chunkBytes / recordBytes ? chunkBytes / recordBytes : 1),
+          maxChunks(maxSpillBytes / (chunkRecords * recordBytes) ? maxSpillBytes / (chunkRecords * recordBytes) : 1) {
+        session = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        static std::atomic<unsigned> instances{ 0 };
+        instance = instances++;
+    }
+    ~SampleStore() { clear(); }
+
+    SampleStore(const SampleStore&) = delete;
+    SampleStore& operator=(const SampleStore&) = delete;
+
+    void push(const ACSharedOutData& snap) {
+        if (memoryCount == memoryCap) {
+            if (dir.empty() || !spillOldest()) { // drop the oldest in memory
+                memoryHead = (memoryHead + 1) % memoryCap;
+                --memoryCount;
+                ++dropCount;
+            }
+        }
+        unsigned char* at = &memory[((memoryHead + memoryCount) % memoryCap) * recordBytes];
+        Header h{ snap.sampledNs, snap.sampledUtcNs, snap.physicsPacketId, snap.graphicsPacketId };
+        std::memcpy(at, &h, sizeof(h));
+        std::memcpy(at + sizeof(h), snap.values, values * sizeof(ACValue));
+        ++memoryCount;
+    }
+
+    // Oldest sample into out (values, packetIds and sample times are set)
+    bool pop(ACSharedOutData& out) {
+        if (!chunks.empty() && chunks.front().read < chunks.front().written) {
+            Chunk& c = chunks.front();
+            const unsigned char* data = chunkData(c);
+            if (!data) { // unreadable, give its samples up
+                dropCount += c.written - c.read;
+                dropChunk(false);
+                return pop(out);
+            }
+            decode(data + c.read * recordBytes, out);
+            if (++c.read == c.written && (chunks.size() > 1 || c.written == chunkRecords)) dropChunk(false);
+            else if (c.read == c.written && chunks.size() == 1) { c.read = c.written = 0; } // reuse the open chunk
+            return true;
+        }
+        if (memoryCount == 0) return false;
+        decode(&memory[memoryHead * recordBytes], out);
+        memoryHead = (memoryHead + 1) % memoryCap;
+        --memoryCount;
+        return true;
+    }
+
+    size_t size() const {
+        size_t n = memoryCount;
+        for (const Chunk& c : chunks) n += c.written - c.read;
+        return n;
+    }
+    bool empty() const { return size() == 0; }
+    size_t spilledSamples() const { return size() - memoryCount; }
+    uint64_t spillBytes() const { return spilledSamples() * recordBytes; }
+    uint64_t dropped() const { return dropCount; }
+    bool spillFailed() const { return failed; }
+
+    // Deletes every chunk file
+    void clear() {
+        while (!chunks.empty()) dropChunk(false);
+        memoryHead = memoryCount = 0;
+    }
+
+private:
+    struct Header {
+        int64_t sampledNs;
+        int64_t sampledUtcNs;
+        int32_t physicsPacketId;
+        int32_t graphicsPacketId;
+    };
+
+    struct Chunk {
+        uint32_t index;
+        size_t written; // records
+        size_t read;
+    };
+
+    size_t values;
+    size_t recordBytes;
+    std::vector<unsigned char> memory;
+    size_t memoryCap;
+    size_t memoryHead{ 0 };
+    size_t memoryCount{ 0 };
+
+    std::string dir;
+    size_t chunkRecords;
+    size_t maxChunks;
+    long long session{ 0 };
+    unsigned instance{ 0 }; // several stores may spill into one directory
+    uint32_t nextChunk{ 0 };
+    std::deque<Chunk> chunks; // oldest first; only the last one is being written
+    MappedFile writeFile;     // chunks.back() while it has room
+    MappedFile readFile;      // chunks.front() once it is full and closed
+    uint32_t readIndex{ UINT32_MAX };
+    uint64_t dropCount{ 0 };
+    bool failed{ false };
+
+    std::string chunkPath(uint32_t index) const {
+        char name[64];
+        std::snprintf(name, sizeof(name), "spill-%lld-%u-%04u.bin", session, instance, index);
+        return dir + "/" + name;
+    }
+
+    void decode(const unsigned char* at, ACSharedOutData& out) const {
+        Header h;
+        std::memcpy(&h, at, sizeof(h));
+        std::memcpy(out.values, at + sizeof(h), values * sizeof(ACValue));
+        out.count = static_cast<uint32_t>(values);
+        out.sampledNs = h.sampledNs;
+        out.sampledUtcNs = h.sampledUtcNs;
+        out.physicsPacketId = h.physicsPacketId;
+        out.graphicsPacketId = h.graphicsPacketId;
+        out.ok = true;
+    }
+
+    const unsigned char* chunkData(const Chunk& c) {
+        if (writeFile.isOpen() && &c == &chunks.back()) return writeFile.data();
+        if (readIndex != c.index) {
+            if (!readFile.openRead(chunkPath(c.index))) {
+                std::cerr << "Cannot read back spill file: " << chunkPath(c.index) << "\n";
+                failed = true;
+            }
+            readIndex = c.index;
+        }
+        return readFile.data();
+    }
+
+    // Moves the oldest memory sample to the end of the spill files
+    bool spillOldest() {
+        if (failed) return false;
+        if (chunks.empty() || chunks.back().written == chunkRecords) {
+            if (chunks.size() == maxChunks) dropChunk(true);
+            if (writeFile.isOpen()) writeFile.close();
+            Chunk c{ nextChunk++, 0, 0 };
+            if (!writeFile.create(chunkPath(c.index), chunkRecords * recordBytes)) {
+                std::cerr << "Cannot create spill file: " << chunkPath(c.index) << "\n";
+                failed = true;
+                return false;
+            }
+            chunks.push_back(c);
+        }
+        Chunk& c = chunks.back();
+        std::memcpy(writeFile.data() + c.written * recordBytes, &memory[memoryHead * recordBytes], recordBytes);
+        ++c.written;
+        memoryHead = (memoryHead + 1) % memoryCap;
+        --memoryCount;
+        return true;
+    }
+
+    void dropChunk(bool overflow) {
+        Chunk c = chunks.front();
+        if (overflow) dropCount += c.written - c.read;
+        if (readIndex == c.index) { readFile.close(); readIndex = UINT32_MAX; }
+        if (chunks.size() == 1 && writeFile.isOpen()) writeFile.close();
+        chunks.pop_front();
+        std::remove(chunkPath(c.index).c_str());
+    }
+};
@@ -0,0 +1,191 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a named shared-memory page (e.g. "acpmf_physics").
+// Backends map the producer's page in place, readers never get a copy.
+class SharedMemoryView {
+public:
+    virtual ~SharedMemoryView() {}
+
+    virtual bool open(const std::string& name, size_t size) = 0;
+    virtual void close() = 0;
+
+    const void* data() const { return view; }
+    size_t size() const { return viewSize; }
+
+protected:
+    const void* view{ nullptr };
+    size_t viewSize{ 0 };
+};
+
+#ifdef _WIN32
+
+// Win32 file mapping, as created by Assetto Corsa ("Local\\<name>")
+class Win32SharedMemoryView : public SharedMemoryView {
+public:
+    ~Win32SharedMemoryView() { close(); }
+
+    bool open(const std::string& name, size_t size) override {
+        close();
+        std::wstring wname = L"Local\\" + std::wstring(name.begin(), name.end());
+        hMapFile = OpenFileMappingW(FILE_MAP_READ, FALSE, wname.c_str());
+        if (!hMapFile) return false;
+
+        view = MapViewOfFile(hMapFile, FILE_MAP_READ, 0, 0, size);
+        if (!view) { close(); return false; }
+
+        viewSize = size;
+        return true;
+    }
+
+    void close() override {
+        if (view) { UnmapViewOfFile(view); view = nullptr; }
+        if (hMapFile) { CloseHandle(hMapFile); hMapFile = nullptr; }
+        viewSize = 0;
+    }
+
+private:
+    HANDLE hMapFile{ nullptr };
+};
+
+#else
+
+// POSIX shm object ("/<name>"), same page layout as the Win32 mapping
+class PosixSharedMemoryView : public SharedMemoryView {
+public:
+    ~PosixSharedMemoryView() { close(); }
+
+    bool open(const std::string& name, size_t size) override {
+        close();
+        int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+
+        // Refuse objects smaller than the layout we are going to read
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < size) { ::close(fd); return false; }
+
+        void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // the mapping keeps the object alive
+        if (p == MAP_FAILED) return false;
+
+        view = p;
+        viewSize = size;
+        return true;
+    }
+
+    void close() override {
+        if (view) { munmap(const_cast<void*>(view), viewSize); view = nullptr; }
+        viewSize = 0;
+    }
+};
+
+#endif
+
+// Backend for the platform we are built on
+inline std::unique_ptr<SharedMemoryView> makeSharedMemoryView() {
+#ifdef _WIN32
+    return std::unique_ptr<SharedMemoryView>(new Win32SharedMemoryView());
+#else
+    return std::unique_ptr<SharedMemoryView>(new PosixSharedMemoryView());
+#endif
+}
+
+// Writable named page, for tools that stand in for the game (replay,
+// synthetic data). Readers open it with SharedMemoryView as usual.
+class SharedMemoryPage {
+public:
+    virtual ~SharedMemoryPage() {}
+
+    virtual bool create(const std::string& name, size_t size) = 0;
+    virtual void close() = 0;
+
+    void* data() const { return page; }
+    size_t size() const { return pageSize; }
+
+protected:
+    void* page{ nullptr };
+    size_t pageSize{ 0 };
+};
+
+#ifdef _WIN32
+
+// Pagefile-backed mapping; it lives as long as any process keeps it open
+class Win32SharedMemoryPage : public SharedMemoryPage {
+public:
+    ~Win32SharedMemoryPage() { close(); }
+
+    bool create(const std::string& name, size_t size) override {
+        close();
+        std::wstring wname = L"Local\\" + std::wstring(name.begin(), name.end());
+        hMapFile = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size), wname.c_str());
+        if (!hMapFile) return false;
+
+        page = MapViewOfFile(hMapFile, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (!page) { close(); return false; }
+
+        pageSize = size;
+        return true;
+    }
+
+    void close() override {
+        if (page) { UnmapViewOfFile(page); page = nullptr; }
+        if (hMapFile) { CloseHandle(hMapFile); hMapFile = nullptr; }
+        pageSize = 0;
+    }
+
+private:
+    HANDLE hMapFile{ nullptr };
+};
+
+#else
+
+// POSIX shm object, unlinked again on close so no stale page outlives us
+class PosixSharedMemoryPage : public SharedMemoryPage {
+public:
+    ~PosixSharedMemoryPage() { close(); }
+
+    bool create(const std::string& name, size_t size) override {
+        close();
+        path = "/" + name;
+        int fd = shm_open(path.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) return false;
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) { ::close(fd); shm_unlink(path.c_str()); return false; }
+
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) { shm_unlink(path.c_str()); return false; }
+
+        page = p;
+        pageSize = size;
+        return true;
+    }
+
+    void close() override {
+        if (page) { munmap(page, pageSize); page = nullptr; shm_unlink(path.c_str()); }
+        pageSize = 0;
+    }
+
+private:
+    std::string path;
+};
+
+#endif
+
+inline std::unique_ptr<SharedMemoryPage> makeSharedMemoryPage() {
+#ifdef _WIN32
+    return std::unique_ptr<SharedMemoryPage>(new Win32SharedMemoryPage());
+#else
+    return std::unique_ptr<SharedMemoryPage>(new PosixSharedMemoryPage());
+#endif
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// What the consumer gets when the producer outruns it
+enum class OverflowPolicy {
+    DropOldest, // pop() every queued item in order; a full ring loses its oldest
+    Coalesce    // popLatest() only the newest item, skipping the backlog
+};
+
+// Lock-free single-producer/single-consumer ring of plain data items.
+// The producer never blocks: when the ring is full it drops the oldest item
+// by advancing the read index itself, and may then overwrite the slot the
+// consumer is copying. Every slot therefore carries a sequence number (a
+// per-slot seqlock): odd while the producer writes it, 2 * (index + 1) once
+// item `index` is complete. The consumer checks it before and after its
+// copy and only then claims the item with a CAS on the read index, so a
+// copy that overlapped a write is never used, only retried (the same idea
+// as the packetId check on the AC pages).
+template <typename T>
+class SpscRing {
+    // Items are copied while they may change: their copy must not depend on
+    // pointers or resources, only bounds-check what it reads (see ACSharedOutData)
+    static_assert(std::is_trivially_destructible<T>::value, "SpscRing items are copied while they may change");
+
+public:
+    // capacity is rounded up to a power of two (at least 2)
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots.reset(new Slot[size]);
+        count = size;
+        mask = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer. Returns false if an old item had to be dropped.
+    bool push(const T& item) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t t = tail.load(std::memory_order_acquire);
+        bool dropped = false;
+        if (h - t > mask) {
+            // Full: drop the oldest unless the consumer just took it
+            if (tail.compare_exchange_strong(t, t + 1, std::memory_order_acq_rel)) {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                dropped = true;
+            }
+        }
+        Slot& slot = slots[h & mask];
+        slot.seq.store(2 * h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release); // odd before any byte of the item changes
+        slot.item = item;
+        slot.seq.store(2 * h + 2, std::memory_order_release);
+        head.store(h + 1, std::memory_order_release);
+        return !dropped;
+    }
+
+    // Consumer, DropOldest policy: oldest queued item
+    bool pop(T& out) {
+        for (;;) {
+            uint64_t t = tail.load(std::memory_order_acquire);
+            uint64_t h = head.load(std::memory_order_acquire);
+            if (t == h) return false;
+            if (!read(t, out)) continue; // overwritten meanwhile, the read index has moved
+            if (tail.compare_exchange_strong(t, t + 1, std::memory_order_acq_rel)) return true;
+        }
+    }
+
+    // Consumer, Coalesce policy: newest queued item, older ones are skipped
+    bool popLatest(T& out) {
+        for (;;) {
+            uint64_t t = tail.load(std::memory_order_acquire);
+            uint64_t h = head.load(std::memory_order_acquire);
+            if (t == h) return false;
+            if (!read(h - 1, out)) continue;
+            if (tail.compare_exchange_strong(t, h, std::memory_order_acq_rel)) {
+                coalescedCount.fetch_add(h - t - 1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    bool pop(T& out, OverflowPolicy policy) {
+        return policy == OverflowPolicy::Coalesce ? popLatest(out) : pop(out);
+    }
+
+    size_t capacity() const { return count; }
+    size_t size() const {
+        return static_cast<size_t>(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+    }
+    uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+    uint64_t coalesced() const { return coalescedCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{ 0 };
+        T item;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t count{ 0 };
+    size_t mask{ 0 };
+
+    // Copies item `index` if its slot holds it, complete, before and after
+    bool read(uint64_t index, T& out) const {
+        const Slot& slot = slots[index & mask];
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before != 2 * index + 2) return false;
+        out = slot.item;
+        std::atomic_thread_fence(std::memory_order_acquire); // the copy before the second check
+        return slot.seq.load(std::memory_order_relaxed) == before;
+    }
+
+    alignas(64) std::atomic<uint64_t> head{ 0 }; // next write, producer only
+    alignas(64) std::atomic<uint64_t> tail{ 0 }; // next read, consumer (and producer on overflow)
+    std::atomic<uint64_t> droppedCount{ 0 };
+    std::atomic<uint64_t> coalescedCount{ 0 };
+};
@@ -0,0 +1,254 @@
+#pragma once
+#include "ACSharedOut.h"
+#include "PublishPlan.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+constexpr size_t MaxEndpoints = 8;   // configured servers
+constexpr size_t MaxPublishers = 32; // servers x rig sessions
+
+// One publish endpoint as the console shows it, copied out of its thread
+struct EndpointStatus {
+    std::string name;
+    bool connected{ false };
+    uint64_t reconnectAttempts{ 0 };
+    uint64_t reconnects{ 0 };
+    uint64_t cycleAllocs{ 0 };
+    size_t valuesSent{ 0 };
+    size_t valueCount{ 0 };
+    uint64_t suppressed{ 0 };
+    uint64_t written{ 0 };      // acknowledged write requests
+    double writeRate{ 0 };      // per second, filled in by the monitor
+    int64_t frameAgeUs{ 0 };
+    size_t queued{ 0 };
+    uint64_t dropped{ 0 };
+    uint64_t coalesced{ 0 };
+    bool asyncWrites{ false };
+    size_t inFlight{ 0 };
+    uint64_t failedRequests{ 0 };
+    uint64_t failedItems{ 0 };
+    bool storing{ false };      // spill files configured
+    size_t stored{ 0 };         // samples waiting for backfill
+    uint64_t spillBytes{ 0 };
+    uint64_t storeDropped{ 0 };
+    uint64_t backfilled{ 0 };
+    bool hosted{ false };       // the embedded server: written counts applied samples
+    bool streamed{ false };     // the PubSub publisher: written counts sent samples
+};
+
+// Everything the console shows, copied out by the monitor loop
+struct StatusFrame {
+    ACSharedOutData snap;
+    bool hasSnap{ false };
+    int delayMs{ 0 };
+    uint64_t readRetries{ 0 };
+    uint64_t tornReads{ 0 };
+    uint64_t frames{ 0 };
+    uint64_t skipped{ 0 };
+    uint64_t duplicates{ 0 };
+    uint64_t aggregated{ 0 };   // physics frames folded into aggregate tags
+    bool recording{ false };
+    uint64_t recordFrames{ 0 };
+    uint64_t recordDropped{ 0 };
+    uint64_t recordBytes{ 0 };
+    uint64_t recordRawBytes{ 0 };
+    bool recordFailed{ false };
+    size_t rigCount{ 1 };
+    std::string shownRig;   // rig the data lines belong to
+    size_t endpointCount{ 0 };
+    EndpointStatus endpoints[MaxPublishers];
+};
+
+// Redraws the status screen in place from its own thread at a low rate.
+// The monitor loop only hands over the latest StatusFrame (a short copy
+// under a mutex), so terminal speed never shows up in publish cadence.
+class StatusRenderer {
+public:
+    // Display lines are looked up in the plan by tag name once, here
+    StatusRenderer(int intervalMs, const PublishPlan& plan) : interval(intervalMs), fields(plan.fields()) {
+        for (Line* group : { carLines, gameLines })
+            for (Line* line = group; line->label; ++line) line->index = plan.find(line->name);
+    }
+    ~StatusRenderer() { stop(); }
+
+    void start() {
+        enableEscapeCodes();
+        running = true;
+        worker = std::thread([this] { run(); });
+    }
+
+    void stop() {
+        running = false;
+        if (worker.joinable()) worker.join();
+    }
+
+    void update(const StatusFrame& frame) {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest = frame;
+    }
+
+private:
+    struct Line {
+        const char* label;
+        const char* name; // tag name in the plan
+        const char* unit;
+        int index;
+    };
+
+    Line carLines[6] = {
+        { "Speed:        ", "speedKmh", " km/h", -1 },
+        { "Engine RPM:   ", "engineRPM", " RPM", -1 },
+        { "Steer Angle:  ", "steerAngle", " degrees", -1 },
+        { "Gear:         ", "gear", "", -1 },
+        { "Fuel:         ", "fuel", " liters", -1 },
+        { nullptr, nullptr, nullptr, -1 },
+    };
+    Line gameLines[6] = {
+        { "Completed Laps: ", "completedLaps", "", -1 },
+        { "Position:       ", "position", "", -1 },
+        { "Current Time:   ", "currentTime", "", -1 },
+        { "Last Time:      ", "lastTime", "", -1 },
+        { "Best Time:      ", "bestTime", "", -1 },
+        { nullptr, nullptr, nullptr, -1 },
+    };
+
+    std::chrono::milliseconds interval;
+    const ACField* fields;
+    std::atomic<bool> running{ false };
+    std::thread worker;
+    std::mutex mutex;
+    StatusFrame latest;
+
+    static void enableEscapeCodes() {
+#ifdef _WIN32
+        HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        if (out != INVALID_HANDLE_VALUE && GetConsoleMode(out, &mode))
+            SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+#endif
+    }
+
+    void run() {
+        std::fputs("\x1b[2J", stdout); // clear once, then redraw in place
+        while (running) {
+            StatusFrame frame;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                frame = latest;
+            }
+            std::string text = render(frame);
+            std::fwrite(text.data(), 1, text.size(), stdout);
+            std::fflush(stdout);
+            std::this_thread::sleep_for(interval);
+        }
+    }
+
+    void renderLines(std::ostringstream& out, const Line* lines, const ACSharedOutData& snap, const char* eol) const {
+        for (const Line* line = lines; line->label; ++line) {
+            out << line->label;
+            if (line->index < 0) { out << "-" << eol; continue; }
+            const ACValue& v = snap.values[fields[line->index].slot];
+            switch (fields[line->index].type) {
+            case ACValueType::Float: out << v.f; break;
+            case ACValueType::LapTime: {
+                char text[16];
+                formatLapTime(v.i, text, sizeof(text));
+                out << text;
+                break;
+            }
+            default: out << v.i; break;
+            }
+            out << line->unit << eol;
+        }
+    }
+
+    static void renderEndpoint(std::ostringstream& out, const EndpointStatus& e, const char* eol) {
+        out << eol << "ENDPOINT: " << e.name << eol;
+        out << "--------------------------" << eol;
+        if (e.hosted) {
+            char rate[32];
+            std::snprintf(rate, sizeof(rate), "%.1f", e.writeRate);
+            out << "Serving:        " << rate << " samples/s, " << e.written << " applied" << eol;
+            out << "Frame age:      " << e.frameAgeUs << " us at last update" << eol;
+            out << "Values updated: " << e.valuesSent << " of " << e.valueCount << " (unchanged: " << e.suppressed
+                << ", failed: " << e.failedItems << ")" << eol;
+            out << "Queue:          " << e.queued << " queued, " << e.dropped << " dropped, " << e.coalesced << " coalesced" << eol;
+            return;
+        }
+        if (e.streamed) {
+            char rate[32];
+            std::snprintf(rate, sizeof(rate), "%.1f", e.writeRate);
+            out << "Streaming:      " << rate << " samples/s, " << e.written << " sent, " << e.dropped
+                << " dropped, " << e.failedItems << " failed" << eol;
+            out << "Frame age:      " << e.frameAgeUs << " us at last send" << eol;
+            return;
+        }
+        if (e.connected)
+            out << "Connection:     up, " << e.reconnects << " reconnects" << eol;
+        else
+            out << "Connection:     DOWN, reconnecting (attempt " << e.reconnectAttempts << ")" << eol;
+        char rate[32];
+        std::snprintf(rate, sizeof(rate), "%.1f", e.writeRate);
+        out << "Throughput:     " << rate << " writes/s, " << e.written << " written" << eol;
+        out << "Frame age:      " << e.frameAgeUs << " us at last write" << eol;
+        out << "Heap allocs:    " << e.cycleAllocs << " per cycle" << eol;
+        out << "Values sent:    " << e.valuesSent << " of " << e.valueCount << " (suppressed: " << e.suppressed << ")" << eol;
+        out << "Queue:          " << e.queued << " queued, " << e.dropped << " dropped, " << e.coalesced << " coalesced" << eol;
+        if (e.asyncWrites)
+            out << "Async writes:   " << e.inFlight << " in flight, " << e.failedRequests
+                << " failed (" << e.failedItems << " items)" << eol;
+        if (e.stored || e.backfilled || e.storeDropped) {
+            out << "Backfill:       " << e.stored << " stored";
+            if (e.storing) out << " (" << e.spillBytes / 1024 << " KiB on disk)";
+            out << ", " << e.backfilled << " sent, " << e.storeDropped << " dropped" << eol;
+        }
+    }
+
+    std::string render(const StatusFrame& f) const {
+        const char* eol = "\x1b[K\n"; // clear the rest of each line
+
+        std::ostringstream out;
+        out << "\x1b[H";
+        out << " #####################################" << eol;
+        out << " # Assetto Corsa - XChange Interface #" << eol;
+        out << " #####################################" << eol << eol;
+        if (!f.hasSnap) {
+            out << "Waiting for the first sample..." << eol << "\x1b[J";
+            return out.str();
+        }
+        out << "Sampling every " << f.delayMs << " ms. Press Ctrl+C to stop." << eol << eol;
+
+        out << "CAR DATA: " << f.delayMs << "ms update" << eol;
+        out << "--------------------------" << eol;
+        renderLines(out, carLines, f.snap, eol);
+        out << eol;
+
+        out << "GAME INFO:" << eol;
+        out << "--------------------------" << eol;
+        renderLines(out, gameLines, f.snap, eol);
+        out << eol;
+
+        if (f.rigCount > 1) out << "Rigs:           " << f.rigCount << ", showing " << f.shownRig << eol;
+        out << "Read retries:   " << f.readRetries << " (torn: " << f.tornReads << ")" << eol;
+        out << "Frames:         " << f.frames << " seen, " << f.skipped << " skipped, " << f.duplicates << " duplicated" << eol;
+        if (f.aggregated) out << "Aggregated:     " << f.aggregated << " physics frames" << eol;
+        if (f.recording)
+            out << "Recording:      " << f.recordFrames << " frames, " << f.recordDropped << " dropped, "
+                << f.recordBytes / 1024 << " KiB (" << (f.recordRawBytes ? f.recordBytes * 100 / f.recordRawBytes : 0)
+                << "% of raw)" << (f.recordFailed ? " STOPPED" : "") << eol;
+        for (size_t i = 0; i < f.endpointCount; ++i) renderEndpoint(out, f.endpoints[i], eol);
+        out << eol << "Press Ctrl+C to exit..." << "\x1b[K" << "\x1b[J";
+        return out.str();
+    }
+};
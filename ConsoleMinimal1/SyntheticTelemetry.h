@@ -0,0 +1,282 @@
+#pragma once
+#include "ACSharedOut.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+struct SyntheticConfig {
+    uint64_t seed{ 1 };
+    double physicsHz{ 333.0 };
+    double graphicsHz{ 60.0 };
+    double density{ 0.5 }; // share of secondary channels that move each step, 0..1
+};
+
+// Deterministic stand-in for the game: a car lapping a 4 km track, with
+// throttle/brake following a speed profile, an rpm-driven gearbox, lap and
+// sector timers and noisy per-wheel data. The same config produces the same
+// pages, step for step, on the same platform and runtime (own PRNG, fixed
+// step); std::sin/cos may differ in the last bits between C runtimes.
+//
+// The driving signals (speed, rpm, gear, pedals, lap timing, position)
+// move every step. Everything else moves with probability density, so
+// deadband and change-detection paths can be exercised at a known rate.
+class SyntheticTelemetry {
+public:
+    explicit SyntheticTelemetry(const SyntheticConfig& config) : cfg(config) { reset(); }
+
+    void reset() {
+        std::memset(&phys, 0, sizeof(phys));
+        std::memset(&gfx, 0, sizeof(gfx));
+        rng = cfg.seed ? cfg.seed : 1;
+        steps = 0;
+        speed = 20.0;
+        lapDistance = 0.0;
+        gear = 1;
+        heading = 0.0;
+        graphicsDue = 0.0;
+        lapMs = 0.0;
+        sectorStartMs = 0.0;
+
+        phys.fuel = 60.0f;
+        phys.autoShifterOn = 1;
+        phys.tc = 0.2f;
+        phys.abs = 0.3f;
+        phys.engineBrake = 3;
+        phys.ersRecoveryLevel = 2;
+        phys.ersPowerLevel = 2;
+        phys.ballast = 0.0f;
+        phys.airDensity = 1.2f;
+        phys.airTemp = 24.0f;
+        phys.roadTemp = 32.0f;
+        phys.brakeBias = 0.58f;
+        phys.cgHeight = 0.32f;
+        for (int w = 0; w < 4; ++w) {
+            phys.wheelsPressure[w] = 27.5f;
+            phys.tyreCoreTemperature[w] = 80.0f;
+            phys.brakeTemp[w] = 300.0f;
+            phys.camberRAD[w] = -0.05f;
+            phys.tyreContactNormal[w][1] = 1.0f;
+        }
+
+        gfx.status = 2; // AC_LIVE
+        gfx.session = 0;
+        gfx.position = 1;
+        gfx.numberOfLaps = 20;
+        gfx.sessionTimeLeft = 3600000.0f;
+        gfx.replayTimeMultiplier = 1.0f;
+        gfx.idealLineOn = 0;
+        gfx.surfaceGrip = 0.98f;
+        gfx.windSpeed = 3.0f;
+        gfx.windDirection = 180.0f;
+        setText(gfx.tyreCompound, 33, "SM");
+        setText(gfx.lastTime, 15, "-:--:---");
+        setText(gfx.bestTime, 15, "-:--:---");
+    }
+
+    // Advance one physics step (1 / physicsHz); the graphics page moves
+    // on at graphicsHz
+    void step() {
+        const double dt = 1.0 / cfg.physicsHz;
+        ++steps;
+        drive(dt);
+        secondary();
+        ++phys.packetId;
+
+        graphicsDue += dt;
+        if (graphicsDue >= 1.0 / cfg.graphicsHz) {
+            graphicsDue -= 1.0 / cfg.graphicsHz;
+            graphics();
+            ++gfx.packetId;
+        }
+    }
+
+    const SPageFilePhysics& physics() const { return phys; }
+    const SPageFileGraphics& graphicsPage() const { return gfx; }
+    int64_t timeNs() const { return static_cast<int64_t>(steps * 1e9 / cfg.physicsHz); }
+
+private:
+    static constexpr double trackLength = 4000.0; // m
+    static constexpr double pi = 3.14159265358979323846;
+    static constexpr int gears = 6;
+
+    SyntheticConfig cfg;
+    SPageFilePhysics phys;
+    SPageFileGraphics gfx;
+    uint64_t rng{ 1 };
+    uint64_t steps{ 0 };
+    double speed{ 0 };       // m/s
+    double lapDistance{ 0 }; // m
+    int gear{ 1 };           // 1..gears
+    double heading{ 0 };
+    double graphicsDue{ 0 };
+    double lapMs{ 0 };
+    double sectorStartMs{ 0 };
+
+    // splitmix64: tiny, and the same sequence everywhere unlike <random> distributions
+    uint64_t nextRandom() {
+        uint64_t z = (rng += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    double uniform() { return (nextRandom() >> 11) * (1.0 / 9007199254740992.0); }
+    double noise(double amount) { return (uniform() + uniform() - 1.0) * amount; }
+    bool moves() { return uniform() < cfg.density; }
+
+    static void setText(char16_t* dst, size_t size, const char* text) {
+        size_t i = 0;
+        for (; text[i] && i + 1 < size; ++i) dst[i] = static_cast<char16_t>(text[i]);
+        for (; i < size; ++i) dst[i] = 0;
+    }
+
+    // AC's own "m:ss:mmm" lap time text
+    static void setLapText(char16_t* dst, int ms) {
+        char text[16];
+        std::snprintf(text, sizeof(text), "%d:%02d:%03d", ms / 60000, (ms / 1000) % 60, ms % 1000);
+        setText(dst, 15, text);
+    }
+
+    double targetSpeed(double s) const {
+        double x = 2.0 * pi * s / trackLength;
+        return 50.0 + 25.0 * std::sin(3.0 * x) + 8.0 * std::sin(7.0 * x + 1.0);
+    }
+
+    double curvature(double s) const {
+        double x = 2.0 * pi * s / trackLength;
+        return 0.01 * std::cos(3.0 * x) + 0.004 * std::sin(5.0 * x);
+    }
+
+    void drive(double dt) {
+        // Driver: chase the speed profile
+        double error = targetSpeed(lapDistance + speed * 0.5) - speed;
+        double gas = error > 0 ? std::fmin(error / 5.0, 1.0) : 0.0;
+        double brake = error < 0 ? std::fmin(-error / 5.0, 1.0) : 0.0;
+        double accel = gas * 8.0 - brake * 15.0 - 0.0004 * speed * speed;
+        speed = std::fmax(speed + accel * dt, 1.0);
+
+        // Gearbox: shift on rpm
+        static const double rpmPerMs[gears] = { 300.0, 210.0, 160.0, 130.0, 110.0, 95.0 };
+        double rpm = speed * rpmPerMs[gear - 1];
+        if (rpm > 7800.0 && gear < gears) ++gear;
+        else if (rpm < 3500.0 && gear > 1) --gear;
+        rpm = std::fmax(speed * rpmPerMs[gear - 1], 900.0);
+
+        double curv = curvature(lapDistance);
+        double yawRate = speed * curv;
+        heading += yawRate * dt;
+        lapDistance += speed * dt;
+        lapMs += dt * 1000.0;
+        if (lapDistance >= trackLength) completeLap();
+
+        phys.gas = static_cast<float>(gas);
+        phys.brake = static_cast<float>(brake);
+        phys.clutch = 1.0f;
+        phys.fuel = static_cast<float>(std::fmax(phys.fuel - gas * 0.05 * dt, 0.0));
+        phys.gear = gear + 1; // AC: 0 = R, 1 = N
+        phys.engineRPM = static_cast<int>(rpm);
+        phys.steerAngle = static_cast<float>(curv * 30.0);
+        phys.speedKmh = static_cast<float>(speed * 3.6);
+        phys.heading = static_cast<float>(std::fmod(heading, 2.0 * pi));
+        phys.velocity[0] = static_cast<float>(speed * std::sin(heading));
+        phys.velocity[2] = static_cast<float>(speed * std::cos(heading));
+        phys.localVelocity[0] = static_cast<float>(speed * curv * 0.5);
+        phys.localVelocity[2] = static_cast<float>(speed);
+        phys.accG[0] = static_cast<float>(speed * yawRate / 9.81);
+        phys.accG[2] = static_cast<float>(accel / 9.81);
+        phys.localAngularVel[1] = static_cast<float>(yawRate);
+        phys.finalFF = static_cast<float>(std::fmin(std::fabs(curv) * speed * 0.05, 1.0));
+        phys.performanceMeter = static_cast<float>(std::sin(lapDistance / 300.0) * 0.5);
+        phys.turboBoost = static_cast<float>(gas * 1.2);
+        phys.kersInput = static_cast<float>(gas);
+        for (int w = 0; w < 4; ++w) phys.wheelAngularSpeed[w] = static_cast<float>(speed / 0.33);
+    }
+
+    void completeLap() {
+        lapDistance -= trackLength;
+        int ms = static_cast<int>(lapMs);
+        gfx.iLastTime = ms;
+        if (gfx.iBestTime == 0 || ms < gfx.iBestTime) gfx.iBestTime = ms;
+        ++gfx.completedLaps;
+        lapMs = 0.0;
+    }
+
+    // Per-wheel and slow channels, each moving with probability density
+    void secondary() {
+        double load = 3500.0 + 20.0 * speed;
+        for (int w = 0; w < 4; ++w) {
+            bool front = w < 2;
+            double side = (w % 2 == 0) ? 1.0 : -1.0; // left wheels load up in right turns
+            if (moves()) phys.wheelSlip[w] = static_cast<float>(std::fabs(phys.brake * 0.3 + phys.gas * (front ? 0.05 : 0.2) + noise(0.05)));
+            if (moves()) phys.wheelLoad[w] = static_cast<float>(load * (1.0 + side * phys.accG[0] * 0.3) + noise(50.0));
+            if (moves()) phys.wheelsPressure[w] = static_cast<float>(27.5 + phys.tyreCoreTemperature[w] * 0.02 + noise(0.05));
+            if (moves()) phys.tyreWear[w] = static_cast<float>(std::fmax(100.0 - steps * 1e-5 - std::fabs(noise(0.01)), 0.0));
+            if (moves()) phys.tyreDirtyLevel[w] = static_cast<float>(std::fabs(noise(0.1)));
+            if (moves()) phys.tyreCoreTemperature[w] = static_cast<float>(80.0 + speed * 0.2 + noise(1.0));
+            if (moves()) phys.suspensionTravel[w] = static_cast<float>(0.05 + phys.accG[2] * (front ? -0.01 : 0.01) + noise(0.005));
+            if (moves()) phys.brakeTemp[w] = static_cast<float>(300.0 + phys.brake * 400.0 + noise(5.0));
+            if (moves()) phys.tyreTempI[w] = static_cast<float>(phys.tyreCoreTemperature[w] + 5.0 + noise(1.0));
+            if (moves()) phys.tyreTempM[w] = static_cast<float>(phys.tyreCoreTemperature[w] + noise(1.0));
+            if (moves()) phys.tyreTempO[w] = static_cast<float>(phys.tyreCoreTemperature[w] - 5.0 + noise(1.0));
+            if (moves()) phys.camberRAD[w] = static_cast<float>(-0.05 + noise(0.005));
+            if (moves()) {
+                double px = (front ? 1.3 : -1.3), pz = side * 0.8;
+                phys.tyreContactPoint[w][0] = static_cast<float>(gfx.carCoordinates[0] + px + noise(0.01));
+                phys.tyreContactPoint[w][1] = static_cast<float>(noise(0.01));
+                phys.tyreContactPoint[w][2] = static_cast<float>(gfx.carCoordinates[2] + pz + noise(0.01));
+            }
+            if (moves()) {
+                phys.tyreContactHeading[w][0] = static_cast<float>(std::sin(heading));
+                phys.tyreContactHeading[w][2] = static_cast<float>(std::cos(heading));
+            }
+        }
+        if (moves()) phys.pitch = static_cast<float>(phys.accG[2] * -0.01 + noise(0.001));
+        if (moves()) phys.roll = static_cast<float>(phys.accG[0] * 0.01 + noise(0.001));
+        if (moves()) phys.rideHeight[0] = static_cast<float>(0.06 + noise(0.002));
+        if (moves()) phys.rideHeight[1] = static_cast<float>(0.08 + noise(0.002));
+        if (moves()) phys.kersCharge = static_cast<float>(0.5 + 0.5 * std::sin(lapMs / 20000.0));
+        if (moves()) phys.kersCurrentKJ = static_cast<float>(phys.kersCharge * 400.0);
+        if (moves()) phys.ersIsCharging = phys.brake > 0 ? 1 : 0;
+        if (moves()) phys.ersHeatCharging = phys.gas > 0.9 ? 1 : 0;
+        if (moves()) phys.drsAvailable = speed > 60.0 ? 1 : 0;
+        if (moves()) phys.drsEnabled = phys.drsAvailable && phys.gas > 0.99 ? 1 : 0;
+        if (moves()) phys.drs = static_cast<float>(phys.drsEnabled);
+        if (moves()) phys.numberOfTyresOut = uniform() < 0.001 ? 2 : 0;
+        if (moves()) phys.airTemp = static_cast<float>(24.0 + noise(0.05));
+        if (moves()) phys.roadTemp = static_cast<float>(32.0 + noise(0.05));
+        if (moves()) phys.airDensity = static_cast<float>(1.2 + noise(0.001));
+        if (moves()) phys.carDamage[static_cast<int>(uniform() * 5) % 5] = static_cast<float>(uniform() < 0.0005 ? uniform() * 10.0 : 0.0);
+    }
+
+    void graphics() {
+        int ms = static_cast<int>(lapMs);
+        gfx.iCurrentTime = ms;
+        setLapText(gfx.currentTime, ms);
+        if (gfx.iLastTime) setLapText(gfx.lastTime, gfx.iLastTime);
+        if (gfx.iBestTime) setLapText(gfx.bestTime, gfx.iBestTime);
+
+        int sector = static_cast<int>(lapDistance / (trackLength / 3.0));
+        if (sector > 2) sector = 2;
+        if (sector != gfx.currentSectorIndex) {
+            // Back in sector 0 means the lap timer restarted meanwhile
+            gfx.lastSectorTime = sector == 0 ? gfx.iLastTime - static_cast<int>(sectorStartMs)
+                                             : static_cast<int>(lapMs - sectorStartMs);
+            sectorStartMs = sector == 0 ? 0.0 : lapMs;
+            setLapText(gfx.split, gfx.lastSectorTime);
+            gfx.currentSectorIndex = sector;
+        }
+
+        double progress = lapDistance / trackLength;
+        gfx.normalizedCarPosition = static_cast<float>(progress);
+        gfx.distanceTraveled = static_cast<float>(gfx.completedLaps * trackLength + lapDistance);
+        gfx.sessionTimeLeft = static_cast<float>(std::fmax(3600000.0 - steps * 1000.0 / cfg.physicsHz, 0.0));
+        gfx.carCoordinates[0] = static_cast<float>(trackLength / (2.0 * pi) * std::cos(2.0 * pi * progress));
+        gfx.carCoordinates[2] = static_cast<float>(trackLength / (2.0 * pi) * std::sin(2.0 * pi * progress));
+        if (moves()) gfx.windSpeed = static_cast<float>(3.0 + noise(0.5));
+        if (moves()) gfx.windDirection = static_cast<float>(180.0 + noise(10.0));
+        if (moves()) gfx.surfaceGrip = static_cast<float>(0.98 + noise(0.005));
+        if (moves()) gfx.position = 1 + static_cast<int>(uniform() * 1.02); // the odd overtake
+        if (moves()) gfx.flag = uniform() < 0.002 ? 2 : 0;
+    }
+};
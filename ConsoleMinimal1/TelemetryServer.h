@@ -0,0 +1,249 @@
+#pragma once
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include "ACSharedOut.h"
+#include "AllocCounter.h"
+#include "EndpointPublisher.h"
+#include "LatencyReporter.h"
+#include "PreparedWrite.h"
+#include "PublishPlan.h"
+#include "SpscRing.h"
+#include "StatusRenderer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Hosts the plan's tags as variables of an embedded OPC UA server, for
+// consumers that would rather subscribe than be written to. The sampler
+// hands every sample to offer(), which never blocks; the server thread
+// copies it into the variables whose values changed and serves the
+// network in between. Subscriptions are open62541's own MonitoredItems:
+// each client picks its sampling interval and gets notified on change, so
+// any number of subscribers costs one variable update per changed value.
+class TelemetryServer {
+public:
+    // Variables are ns=<namespaceUri>;s=<tag nodeId>, browsable under
+    // Objects/Telemetry. samplingMs is advertised as their minimum
+    // sampling interval (nothing changes faster than the sampler).
+    TelemetryServer(uint16_t serverPort, const std::string& namespaceUri, const PublishPlan& publishPlan, int samplingMs,
+        const PublishOptions& publishOptions)
+        : port(serverPort), uri(namespaceUri), plan(publishPlan), minSamplingMs(samplingMs), options(publishOptions),
+          server(UA_Server_new()), ring(publishOptions.queueSize) {
+        shown.name = "server opc.tcp://:" + std::to_string(port);
+        shown.hosted = true;
+        shown.valueCount = plan.size();
+    }
+
+    ~TelemetryServer() {
+        stop();
+        if (started) UA_Server_run_shutdown(server);
+        for (auto& w : nodes) UA_NodeId_clear(&w.nodeId);
+        UA_Server_delete(server);
+    }
+
+    TelemetryServer(const TelemetryServer&) = delete;
+    TelemetryServer& operator=(const TelemetryServer&) = delete;
+
+    // Address space and listening socket; served from start() on.
+    // Unencrypted and anonymous, the variables are read-only.
+    bool configure() {
+        UA_StatusCode sc = UA_ServerConfig_setMinimal(UA_Server_getConfig(server), port, nullptr);
+        if (sc != UA_STATUSCODE_GOOD) {
+            std::cerr << "[" << shown.name << "] UA_ServerConfig_setMinimal failed: 0x" << std::hex << sc << std::dec << "\n";
+            return false;
+        }
+        ns = UA_Server_addNamespace(server, uri.c_str());
+
+        UA_NodeId folder = UA_NODEID_STRING(ns, const_cast<char*>("Telemetry"));
+        UA_ObjectAttributes folderAttr = UA_ObjectAttributes_default;
+        folderAttr.displayName = UA_LOCALIZEDTEXT(const_cast<char*>("en-US"), const_cast<char*>("Telemetry"));
+        sc = UA_Server_addObjectNode(server, folder, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), UA_QUALIFIEDNAME(ns, const_cast<char*>("Telemetry")),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE), folderAttr, nullptr, nullptr);
+        if (sc != UA_STATUSCODE_GOOD) {
+            std::cerr << "[" << shown.name << "] Adding the Telemetry folder failed: 0x" << std::hex << sc << std::dec << "\n";
+            return false;
+        }
+
+        // Variant storage is bound once, like a PreparedWrite; apply() only patches it
+        const ACField* fields = plan.fields();
+        values.assign(plan.valueCount(), ACValue());
+        published.assign(plan.valueCount(), ACValue());
+        times.resize(plan.size());
+        nodes.resize(plan.size());
+        for (size_t k = 0; k < plan.size(); ++k) {
+            const ACField& f = fields[k];
+            UA_WriteValue& w = nodes[k];
+            UA_WriteValue_init(&w);
+            w.nodeId = UA_NODEID_STRING_ALLOC(ns, f.nodeId);
+            w.value.hasValue = true;
+            bindWriteValue(w, f, values.data(), times[k]);
+
+            UA_VariableAttributes attr = UA_VariableAttributes_default;
+            const char* label = f.name[0] ? f.name : f.nodeId;
+            attr.displayName = UA_LOCALIZEDTEXT(const_cast<char*>("en-US"), const_cast<char*>(label));
+            attr.value = w.value.value;
+            attr.dataType = w.value.value.type->typeId;
+            UA_UInt32 dims = f.count;
+            if (f.count > 1 && f.type != ACValueType::LapTime) {
+                attr.valueRank = UA_VALUERANK_ONE_DIMENSION;
+                attr.arrayDimensionsSize = 1;
+                attr.arrayDimensions = &dims;
+            }
+            else {
+                attr.valueRank = UA_VALUERANK_SCALAR;
+            }
+            attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+            attr.userAccessLevel = UA_ACCESSLEVELMASK_READ;
+            attr.minimumSamplingInterval = minSamplingMs;
+            // Browse names must be unique under the folder; tag names repeat across rigs
+            sc = UA_Server_addVariableNode(server, w.nodeId, folder, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                UA_QUALIFIEDNAME(ns, const_cast<char*>(f.nodeId)), UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                attr, nullptr, nullptr);
+            if (sc != UA_STATUSCODE_GOOD) {
+                std::cerr << "[" << shown.name << "] Adding variable " << f.nodeId << " failed: 0x"
+                    << std::hex << sc << std::dec << "\n";
+                return false;
+            }
+        }
+
+        sc = UA_Server_run_startup(server);
+        if (sc != UA_STATUSCODE_GOOD) {
+            std::cerr << "[" << shown.name << "] Server startup failed: 0x" << std::hex << sc << std::dec << "\n";
+            return false;
+        }
+        started = true;
+        std::cerr << "[" << shown.name << "] Serving " << plan.size() << " variables in namespace " << ns
+            << " (" << uri << ")\n";
+        return true;
+    }
+
+    void start() {
+        if (!started) return;
+        running = true;
+        worker = std::thread([this] { run(); });
+    }
+
+    void stop() {
+        running = false;
+        if (worker.joinable()) worker.join();
+    }
+
+    // Sampler thread; never blocks
+    void offer(const ACSharedOutData& snap) { ring.push(snap); }
+
+    EndpointStatus status() const {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        return shown;
+    }
+
+    const PublishLatency& latency() const { return stages; }
+    const std::string& name() const { return shown.name; }
+
+private:
+    uint16_t port;
+    std::string uri;
+    const PublishPlan& plan;
+    double minSamplingMs;
+    PublishOptions options;
+    UA_Server* server;
+    UA_UInt16 ns{ 0 };
+    bool started{ false };
+    SpscRing<ACSharedOutData> ring;
+    std::vector<ACValue> values;     // bound to the variants of nodes
+    std::vector<ACValue> published;  // values as last written to the server
+    std::vector<LapTimeText> times;
+    std::vector<UA_WriteValue> nodes; // node id and bound value per field
+    bool primed{ false };
+    PublishLatency stages;
+    std::atomic<bool> running{ false };
+    std::thread worker;
+
+    // Server thread only, copied to shown for the status screen
+    uint64_t cycleAllocs{ 0 };
+    int64_t frameAgeUs{ 0 };
+    uint64_t applied{ 0 };
+    size_t changed{ 0 };
+    uint64_t unchanged{ 0 };
+    uint64_t failedItems{ 0 };
+    mutable std::mutex statusMutex;
+    EndpointStatus shown;
+
+    void publishStatus() {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        shown.connected = true;
+        shown.cycleAllocs = cycleAllocs;
+        shown.valuesSent = changed;
+        shown.suppressed = unchanged;
+        shown.written = applied;
+        shown.frameAgeUs = frameAgeUs;
+        shown.queued = ring.size();
+        shown.dropped = ring.dropped();
+        shown.coalesced = ring.coalesced();
+        shown.failedItems = failedItems;
+    }
+
+    // Writes the variables whose values differ from the last sample;
+    // MonitoredItems pick them up at their next sampling
+    void apply(const ACSharedOutData& snap) {
+        const ACField* fields = plan.fields();
+        std::memcpy(values.data(), snap.values, values.size() * sizeof(ACValue));
+        UA_DateTime ts = toUaDateTime(snap.sampledUtcNs);
+        changed = 0;
+        for (size_t k = 0; k < nodes.size(); ++k) {
+            const ACField& f = fields[k];
+            size_t bytes = f.count * sizeof(ACValue);
+            if (primed && std::memcmp(&values[f.slot], &published[f.slot], bytes) == 0) { ++unchanged; continue; }
+            if (f.type == ACValueType::LapTime)
+                times[k].str.length = formatLapTime(values[f.slot].i, times[k].chars, sizeof(times[k].chars));
+            UA_DataValue& dv = nodes[k].value;
+            dv.hasSourceTimestamp = options.sourceTimestamps;
+            dv.sourceTimestamp = ts;
+            UA_StatusCode sc = UA_Server_writeDataValue(server, nodes[k].nodeId, dv);
+            if (sc != UA_STATUSCODE_GOOD) {
+                if (failedItems++ == 0)
+                    std::cerr << "[" << shown.name << "] Updating " << f.nodeId << " failed: 0x" << std::hex << sc << std::dec << "\n";
+                continue;
+            }
+            std::memcpy(&published[f.slot], &values[f.slot], bytes);
+            ++changed;
+        }
+        primed = true;
+        ++applied;
+    }
+
+    void run() {
+        ACSharedOutData snap; // reused, a snapshot is large to construct
+        while (running.load(std::memory_order_relaxed)) {
+            if (!ring.pop(snap, options.queuePolicy)) { // idle: serve the network
+                UA_Server_run_iterate(server, false);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            uint64_t allocsBefore = heapAllocations();
+            auto popped = std::chrono::steady_clock::now();
+            int64_t poppedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(popped.time_since_epoch()).count();
+            stages.queue.record(poppedNs - snap.sampledNs);
+
+            apply(snap);
+            auto written = std::chrono::steady_clock::now();
+            stages.write.record(written - popped);
+            int64_t ageNs = std::chrono::duration_cast<std::chrono::nanoseconds>(written.time_since_epoch()).count() - snap.sampledNs;
+            stages.age.record(ageNs);
+            frameAgeUs = ageNs / 1000;
+
+            UA_Server_run_iterate(server, false);
+            stages.iterate.record(std::chrono::steady_clock::now() - written);
+            cycleAllocs = heapAllocations() - allocsBefore;
+            stages.cycle.record(std::chrono::steady_clock::now() - popped);
+            publishStatus();
+        }
+    }
+};
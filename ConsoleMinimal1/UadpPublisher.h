@@ -0,0 +1,279 @@
+#pragma once
+#include "ACSharedOut.h"
+#include "LatencyReporter.h"
+#include "PreparedWrite.h"
+#include "PublishPlan.h"
+#include "StatusRenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// OPC UA PubSub publisher (Part 14, UADP over UDP) for consumers on the rig
+// network that need telemetry faster than a write round trip allows. Each
+// rig's share of the plan is one DataSetWriter (id = rig number) in one
+// NetworkMessage:
+//   PublisherId (UInt16), WriterGroupId, NetworkMessage sequence number,
+//   one DataSetMessage: key frame, Variant fields, sequence number and
+//   the sample's read time as timestamp
+// Every message has a fixed layout, so it is encoded once at configure()
+// and publish() only patches sequence numbers, timestamp and values before
+// a non-blocking sendto(): it runs on the sampler thread, without queue or
+// acknowledgements. LapTime tags go out as Int32 milliseconds to keep the
+// layout fixed. Values are copied as they are in memory, which matches the
+// little-endian UA binary encoding on the x86/x64 hosts this runs on.
+class UadpPublisher {
+public:
+    // url: opc.udp://host:port, unicast or multicast (TTL 1, looped back)
+    UadpPublisher(const std::string& url, uint16_t publisherId, uint16_t writerGroupId)
+        : address(url), publisher(publisherId), writerGroup(writerGroupId) {
+        shown.name = "pubsub " + url;
+        shown.streamed = true;
+    }
+
+    ~UadpPublisher() {
+        if (sock != InvalidSocket) closeSocket(sock);
+#ifdef _WIN32
+        if (wsaStarted) WSACleanup();
+#endif
+    }
+
+    UadpPublisher(const UadpPublisher&) = delete;
+    UadpPublisher& operator=(const UadpPublisher&) = delete;
+
+    // One DataSetWriter per fieldsPerWriter fields of plan (one per rig)
+    bool configure(const PublishPlan& plan, size_t fieldsPerWriter) {
+        if (!openSocket()) return false;
+        shown.valueCount = plan.size();
+        const ACField* fields = plan.fields();
+        for (size_t first = 0; first < plan.size(); first += fieldsPerWriter) {
+            size_t count = std::min(fieldsPerWriter, plan.size() - first);
+            Message m;
+            if (!encode(m, static_cast<uint16_t>(writers.size() + 1), fields + first, count)) return false;
+            writers.push_back(std::move(m));
+        }
+        size_t largest = 0;
+        for (const Message& m : writers) largest = std::max(largest, m.bytes.size());
+        std::cerr << "[" << shown.name << "] " << writers.size() << " DataSetWriters, " << largest
+            << " bytes per NetworkMessage, PublisherId " << publisher << ", WriterGroupId " << writerGroup << "\n";
+        if (largest > 1472)
+            std::cerr << "[" << shown.name << "] Messages exceed one Ethernet frame and will be fragmented\n";
+        return true;
+    }
+
+    // Sampler thread: one NetworkMessage per writer, never blocks. A full
+    // socket buffer drops the sample.
+    void publish(const ACSharedOutData& snap) {
+        auto begin = std::chrono::steady_clock::now();
+        int64_t ts = toUaDateTime(snap.sampledUtcNs);
+        for (Message& m : writers) {
+            unsigned char* p = m.bytes.data();
+            put16(p + m.groupSequenceAt, ++m.sequence);
+            put16(p + m.sequenceAt, m.sequence);
+            std::memcpy(p + m.timestampAt, &ts, 8);
+            for (const Slot& s : m.values) std::memcpy(p + s.at, &snap.values[s.slot], s.count * sizeof(ACValue));
+        }
+        auto built = std::chrono::steady_clock::now();
+        stages.build.record(built - begin);
+
+        bool ok = true;
+        for (const Message& m : writers) {
+            int sent = static_cast<int>(sendto(sock, reinterpret_cast<const char*>(m.bytes.data()), static_cast<int>(m.bytes.size()), 0,
+                reinterpret_cast<const sockaddr*>(&target), sizeof(target)));
+            if (sent == static_cast<int>(m.bytes.size())) continue;
+            ok = false;
+            if (wouldBlock()) dropped.fetch_add(1, std::memory_order_relaxed);
+            else if (failed.fetch_add(1, std::memory_order_relaxed) == 0)
+                std::cerr << "[" << shown.name << "] sendto failed: " << lastError() << "\n";
+        }
+        auto sentAt = std::chrono::steady_clock::now();
+        stages.write.record(sentAt - built);
+        int64_t ageNs = std::chrono::duration_cast<std::chrono::nanoseconds>(sentAt.time_since_epoch()).count() - snap.sampledNs;
+        stages.age.record(ageNs);
+        frameAgeUs.store(ageNs / 1000, std::memory_order_relaxed);
+        if (ok) sentSamples.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    EndpointStatus status() const {
+        EndpointStatus s = shown;
+        s.connected = true;
+        s.written = sentSamples.load(std::memory_order_relaxed);
+        s.valuesSent = s.valueCount;
+        s.dropped = dropped.load(std::memory_order_relaxed);
+        s.failedItems = failed.load(std::memory_order_relaxed);
+        s.frameAgeUs = frameAgeUs.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    const PublishLatency& latency() const { return stages; }
+    const std::string& name() const { return shown.name; }
+
+private:
+#ifdef _WIN32
+    typedef SOCKET Socket;
+    static constexpr Socket InvalidSocket = INVALID_SOCKET;
+    static void closeSocket(Socket s) { closesocket(s); }
+    static bool wouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+    static int lastError() { return WSAGetLastError(); }
+    bool wsaStarted{ false };
+#else
+    typedef int Socket;
+    static constexpr Socket InvalidSocket = -1;
+    static void closeSocket(Socket s) { ::close(s); }
+    static bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK; }
+    static int lastError() { return errno; }
+#endif
+
+    // Where publish() patches one value run
+    struct Slot {
+        size_t at;
+        uint32_t slot;
+        uint32_t count;
+    };
+
+    struct Message {
+        std::vector<unsigned char> bytes;
+        size_t groupSequenceAt{ 0 };
+        size_t sequenceAt{ 0 };
+        size_t timestampAt{ 0 };
+        std::vector<Slot> values;
+        uint16_t sequence{ 0 };
+    };
+
+    std::string address;
+    uint16_t publisher;
+    uint16_t writerGroup;
+    Socket sock{ InvalidSocket };
+    sockaddr_in target{};
+    std::vector<Message> writers;
+    PublishLatency stages;
+    EndpointStatus shown;
+    std::atomic<uint64_t> sentSamples{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+    std::atomic<uint64_t> failed{ 0 };
+    std::atomic<int64_t> frameAgeUs{ 0 };
+
+    static void put16(unsigned char* p, uint16_t v) { p[0] = static_cast<unsigned char>(v); p[1] = static_cast<unsigned char>(v >> 8); }
+
+    static void append16(std::vector<unsigned char>& b, uint16_t v) { b.push_back(static_cast<unsigned char>(v)); b.push_back(static_cast<unsigned char>(v >> 8)); }
+
+    static void append32(std::vector<unsigned char>& b, uint32_t v) {
+        for (int i = 0; i < 4; ++i) b.push_back(static_cast<unsigned char>(v >> (8 * i)));
+    }
+
+    bool encode(Message& m, uint16_t writerId, const ACField* fields, size_t count) {
+        std::vector<unsigned char>& b = m.bytes;
+        // NetworkMessage header
+        b.push_back(0x01 | 0x10 | 0x20 | 0x40 | 0x80); // UADP version 1, PublisherId, GroupHeader, PayloadHeader, ExtendedFlags1
+        b.push_back(0x01);                             // ExtendedFlags1: PublisherId is a UInt16
+        append16(b, publisher);
+        b.push_back(0x01 | 0x08);                      // GroupFlags: WriterGroupId, SequenceNumber
+        append16(b, writerGroup);
+        m.groupSequenceAt = b.size();
+        append16(b, 0);
+        b.push_back(1);                                // PayloadHeader: one DataSetMessage
+        append16(b, writerId);
+
+        // DataSetMessage header
+        b.push_back(0x01 | 0x08 | 0x80);               // valid, Variant fields, SequenceNumber, DataSetFlags2
+        b.push_back(0x10);                             // DataSetFlags2: key frame, Timestamp
+        m.sequenceAt = b.size();
+        append16(b, 0);
+        m.timestampAt = b.size();
+        b.insert(b.end(), 8, 0);
+
+        // Key frame: every field as a Variant of fixed size
+        if (count > 0xFFFF) { std::cerr << "[" << shown.name << "] Too many fields for one DataSetMessage\n"; return false; }
+        append16(b, static_cast<uint16_t>(count));
+        for (size_t k = 0; k < count; ++k) {
+            const ACField& f = fields[k];
+            unsigned char type = f.type == ACValueType::Float ? 10 : 6; // Float, Int32 (LapTime as milliseconds)
+            if (f.count > 1) {
+                b.push_back(type | 0x80);
+                append32(b, f.count);
+            }
+            else {
+                b.push_back(type);
+            }
+            m.values.push_back(Slot{ b.size(), f.slot, f.count });
+            b.insert(b.end(), f.count * sizeof(ACValue), 0);
+        }
+        if (b.size() > 65507) {
+            std::cerr << "[" << shown.name << "] DataSetWriter " << writerId << " needs " << b.size()
+                << " bytes, more than one UDP datagram\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool openSocket() {
+        const std::string scheme = "opc.udp://";
+        if (address.compare(0, scheme.size(), scheme) != 0) {
+            std::cerr << "PUBSUB_URL must look like opc.udp://host:port: " << address << "\n";
+            return false;
+        }
+        std::string hostPort = address.substr(scheme.size());
+        size_t slash = hostPort.find('/');
+        if (slash != std::string::npos) hostPort.erase(slash);
+        size_t colon = hostPort.rfind(':');
+        std::string host = hostPort.substr(0, colon);
+        std::string port = colon == std::string::npos ? "4840" : hostPort.substr(colon + 1);
+
+#ifdef _WIN32
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) { std::cerr << "WSAStartup failed\n"; return false; }
+        wsaStarted = true;
+#endif
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo* found = nullptr;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0 || !found) {
+            std::cerr << "[" << shown.name << "] Cannot resolve " << hostPort << "\n";
+            return false;
+        }
+        std::memcpy(&target, found->ai_addr, sizeof(target));
+        freeaddrinfo(found);
+
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock == InvalidSocket) {
+            std::cerr << "[" << shown.name << "] Cannot create a UDP socket: " << lastError() << "\n";
+            return false;
+        }
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        ioctlsocket(sock, FIONBIO, &nonBlocking);
+#else
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+        // Multicast stays on the local network and reaches subscribers on this host
+        if ((ntohl(target.sin_addr.s_addr) >> 28) == 0xE) {
+            int ttl = 1;
+            int loop = 1;
+            setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, reinterpret_cast<const char*>(&ttl), sizeof(ttl));
+            setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, reinterpret_cast<const char*>(&loop), sizeof(loop));
+        }
+        return true;
+    }
+};
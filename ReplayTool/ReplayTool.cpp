@@ -0,0 +1,169 @@
+// Drives the acpmf_physics / acpmf_graphics pages from a recording made with
+// RECORD_DIR, or from the seeded synthetic source, so the bridge (or anything
+// else reading the pages) can run without the game: to reproduce a session,
+// or to find the highest frame rate the bridge keeps up with.
+//
+//   ReplayTool [--speed N | --max] [--mapping NAME] [--loop] <first segment .acrec>
+//   ReplayTool [--speed N | --max] [--mapping NAME] --synthetic [--seed N] [--rate HZ]
+//              [--graphics-rate HZ] [--density D] [--duration S]
+
+#include "ACPageWriter.h"
+#include "Recording.h"
+#include "SyntheticTelemetry.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) { stopRequested = 1; }
+
+static void usage() {
+    std::cerr << "Usage: ReplayTool [--speed N | --max] [--mapping NAME] [--loop] <first segment .acrec>\n"
+        << "       ReplayTool [--speed N | --max] [--mapping NAME] --synthetic [--seed N] [--rate HZ]\n"
+        << "                  [--graphics-rate HZ] [--density D] [--duration S]\n"
+        << "  --speed N            replay at N x real time (default 1)\n"
+        << "  --max                replay as fast as possible\n"
+        << "  --mapping NAME       write NAME_physics / NAME_graphics, e.g. one rig of a RIG_MAP (default acpmf)\n"
+        << "  --loop               start over at the end, packetIds keep counting up\n"
+        << "  --synthetic          generate frames instead of reading a recording\n"
+        << "  --seed N             synthetic: PRNG seed, same seed = same frames (default 1)\n"
+        << "  --rate HZ            synthetic: physics page rate (default 333)\n"
+        << "  --graphics-rate HZ   synthetic: graphics page rate (default 60)\n"
+        << "  --density D          synthetic: share of secondary channels changing per frame, 0..1 (default 0.5)\n"
+        << "  --duration S         synthetic: stop after S seconds of generated data (default: run until Ctrl+C)\n";
+}
+
+int main(int argc, char** argv) {
+    double speed = 1.0;
+    bool maxRate = false;
+    bool loop = false;
+    bool synthetic = false;
+    SyntheticConfig synth;
+    double duration = 0;
+    std::string path;
+    std::string mapping = "acpmf";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--speed" && hasValue) speed = std::atof(argv[++i]);
+        else if (arg == "--max") maxRate = true;
+        else if (arg == "--mapping" && hasValue) mapping = argv[++i];
+        else if (arg == "--loop") loop = true;
+        else if (arg == "--synthetic") synthetic = true;
+        else if (arg == "--seed" && hasValue) synth.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--rate" && hasValue) synth.physicsHz = std::atof(argv[++i]);
+        else if (arg == "--graphics-rate" && hasValue) synth.graphicsHz = std::atof(argv[++i]);
+        else if (arg == "--density" && hasValue) synth.density = std::atof(argv[++i]);
+        else if (arg == "--duration" && hasValue) duration = std::atof(argv[++i]);
+        else if (path.empty() && arg.compare(0, 2, "--") != 0) path = arg;
+        else { usage(); return 1; }
+    }
+    if (speed <= 0 || synthetic == !path.empty()) { usage(); return 1; }
+    if (synthetic && (synth.physicsHz <= 0 || synth.graphicsHz <= 0 || synth.density < 0 || synth.density > 1)) { usage(); return 1; }
+
+    RecordingReader reader;
+    if (!synthetic && !reader.open(path)) return 1;
+    SyntheticTelemetry generator(synth);
+    const int64_t durationNs = static_cast<int64_t>(duration * 1e9);
+
+    ACPageWriter pages;
+    if (!pages.create(mapping)) {
+        std::cerr << "Failed to create the shared memory pages.\n";
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+#ifdef _WIN32
+    timeBeginPeriod(1);
+#endif
+
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    auto lastReport = start;
+    int64_t timelineNs = 0;    // replay position, already divided by speed
+    int64_t prevSampledNs = 0;
+    bool havePrev = false;
+    int physicsOffset = 0, graphicsOffset = 0; // keeps packetIds rising across loops
+    int firstPhysicsId = 0, firstGraphicsId = 0, lastPhysicsId = 0, lastGraphicsId = 0;
+    bool firstOfPass = true;
+    uint64_t frames = 0, framesAtReport = 0;
+    double lagMs = 0;
+
+    RecFrame frame;
+    RecRecordHeader rec;
+    while (!stopRequested) {
+        if (synthetic) {
+            if (durationNs > 0 && generator.timeNs() >= durationNs) break;
+            generator.step();
+            frame.physics = generator.physics();
+            frame.graphics = generator.graphicsPage();
+            frame.sampledNs = generator.timeNs();
+        }
+        else if (!reader.next(frame, rec)) {
+            if (reader.failed() || !loop) break;
+            physicsOffset += lastPhysicsId - firstPhysicsId + 1;
+            graphicsOffset += lastGraphicsId - firstGraphicsId + 1;
+            havePrev = false; // no pause between passes
+            firstOfPass = true;
+            if (!reader.rewind()) break;
+            continue;
+        }
+        if (firstOfPass) {
+            firstPhysicsId = frame.physics.packetId;
+            firstGraphicsId = frame.graphics.packetId;
+            firstOfPass = false;
+        }
+        lastPhysicsId = frame.physics.packetId;
+        lastGraphicsId = frame.graphics.packetId;
+        frame.physics.packetId += physicsOffset;
+        frame.graphics.packetId += graphicsOffset;
+
+        if (!maxRate) {
+            // Keep the recorded spacing between frames; a negative step (clock
+            // jump between segments) is replayed as no gap
+            if (havePrev && frame.sampledNs > prevSampledNs)
+                timelineNs += static_cast<int64_t>((frame.sampledNs - prevSampledNs) / speed);
+            prevSampledNs = frame.sampledNs;
+            havePrev = true;
+
+            auto target = start + std::chrono::nanoseconds(timelineNs);
+            auto ahead = target - clock::now();
+            if (ahead > std::chrono::milliseconds(2)) std::this_thread::sleep_for(ahead - std::chrono::milliseconds(1));
+            while (clock::now() < target) std::this_thread::yield();
+            lagMs = std::chrono::duration<double, std::milli>(clock::now() - target).count();
+        }
+
+        pages.write(frame.physics, frame.graphics);
+        ++frames;
+
+        auto now = clock::now();
+        if (now - lastReport >= std::chrono::seconds(1)) {
+            double seconds = std::chrono::duration<double>(now - lastReport).count();
+            std::cout << "frames " << frames << ", " << static_cast<uint64_t>((frames - framesAtReport) / seconds) << " Hz";
+            if (!maxRate) std::cout << ", lag " << lagMs << " ms";
+            std::cout << "\n";
+            lastReport = now;
+            framesAtReport = frames;
+        }
+    }
+
+    double total = std::chrono::duration<double>(clock::now() - start).count();
+    std::cout << "Replayed " << frames << " frames in " << total << " s ("
+        << (total > 0 ? static_cast<uint64_t>(frames / total) : 0) << " Hz)\n";
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+    return reader.failed() ? 1 : 0;
+}